@@ -0,0 +1,758 @@
+#define _GNU_SOURCE
+
+#include "math.h"
+#include "particle.h"
+
+#include <float.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// NOTE: Microbenchmarks and correctness checks for the `math.h` kernels, and
+// a throughput benchmark for `particle.h`.
+//
+//     $ bin/bench                   # NOTE: Human-readable table.
+//     $ bin/bench json [label]      # NOTE: JSON, for diffing runs.
+//     $ bin/bench flags             # NOTE: Compiler flags it was built with.
+//
+// Set `BENCH_CPU` to choose the core the process is pinned to (default 0).
+
+// NOTE: Passed in by `main` so runs from different flag sets can be told
+// apart.
+#ifndef BENCH_FLAGS
+    #define BENCH_FLAGS "unknown"
+#endif
+
+#define COUNT_INPUTS  1024
+#define COUNT_SAMPLES 31
+#define COUNT_CHECKS  4096
+
+#define WARMUP_NANOSECONDS 200000000
+#define SAMPLE_NANOSECONDS 2000000
+
+// NOTE: Simulated frames before timing `update_particles`, so the pool has
+// reached its steady-state size.
+#define PARTICLE_WARMUP_FRAMES 300
+#define PARTICLE_DT            (1.0f / 60.0f)
+
+// NOTE: Keeps the compiler from discarding results it can prove unused.
+#define KEEP(x) __asm__ volatile("" : : "g"(&(x)) : "memory")
+
+typedef struct {
+    Mat4 mat4s[2][COUNT_INPUTS];
+    Vec3 vec3s[3][COUNT_INPUTS];
+    f32  f32s[4][COUNT_INPUTS];
+} Inputs;
+
+typedef void (*Kernel)(u64 iterations);
+
+typedef struct {
+    const char* name;
+    Kernel      kernel;
+} Bench;
+
+typedef struct {
+    f64 min;
+    f64 median;
+    f64 mean;
+    f64 stddev;
+    f64 max;
+    u64 ops;
+} Summary;
+
+typedef struct {
+    const char* name;
+    f64         ulps;
+    f64         bound;
+} Check;
+
+static Inputs INPUTS;
+
+// NOTE: A single-threaded pool runs every job inline, so the particle
+// numbers are per core.
+static Pool           PARTICLE_POOL = {.len_threads = 1};
+static Particles      PARTICLES;
+static ParticleArrays PARTICLE_ARRAYS[2];
+static f32            PARTICLE_OUT[CAP_PARTICLES * 4];
+
+static const Emitter PARTICLE_EMITTER = {
+    .radius = 0.25f,
+    .spread = 2.5f,
+    .speed_min = 10.0f,
+    .speed_max = 15.0f,
+    .life_min = 1.0f,
+    .life_max = 3.0f,
+    .rate = (f32)CAP_PARTICLES * 0.45f,
+    .gravity = -9.8f,
+    .size = 0.06f,
+};
+
+static u64 get_nanoseconds(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return ((u64)time.tv_sec * 1000000000) + (u64)time.tv_nsec;
+}
+
+static f32 get_random(u32* seed, f32 low, f32 high) {
+    return low + (random_f32(seed) * (high - low));
+}
+
+static Vec3 get_random_vec3(u32* seed, f32 low, f32 high) {
+    Vec3 out = {
+        .x = get_random(seed, low, high),
+        .y = get_random(seed, low, high),
+        .z = get_random(seed, low, high),
+    };
+    return out;
+}
+
+static void set_inputs(void) {
+    u32 seed = 0x2545F491;
+    for (u32 i = 0; i < COUNT_INPUTS; ++i) {
+        for (u32 j = 0; j < 2; ++j) {
+            for (u32 k = 0; k < 4; ++k) {
+                for (u32 l = 0; l < 4; ++l) {
+                    INPUTS.mat4s[j][i].cell[k][l] =
+                        get_random(&seed, -4.0f, 4.0f);
+                }
+            }
+        }
+        for (u32 j = 0; j < 3; ++j) {
+            INPUTS.vec3s[j][i] = get_random_vec3(&seed, -16.0f, 16.0f);
+        }
+        INPUTS.f32s[0][i] = get_random(&seed, -2.0f * PI, 2.0f * PI);
+        INPUTS.f32s[1][i] = get_random(&seed, 0.2f, 2.5f);
+        INPUTS.f32s[2][i] = get_random(&seed, 0.5f, 2.0f);
+        INPUTS.f32s[3][i] = get_random(&seed, 0.01f, 1.0f);
+    }
+}
+
+#define FOR_INPUTS(iterations)                                     \
+    for (u64 iteration = 0; iteration < (iterations); ++iteration) \
+        for (u32 i = 0; i < COUNT_INPUTS; ++i)
+
+static void bench_add_vec3(u64 iterations) {
+    FOR_INPUTS(iterations) {
+        Vec3 out = add_vec3(INPUTS.vec3s[0][i], INPUTS.vec3s[1][i]);
+        KEEP(out);
+    }
+}
+
+static void bench_sub_vec3(u64 iterations) {
+    FOR_INPUTS(iterations) {
+        Vec3 out = sub_vec3(INPUTS.vec3s[0][i], INPUTS.vec3s[1][i]);
+        KEEP(out);
+    }
+}
+
+static void bench_mul_vec3_f32(u64 iterations) {
+    FOR_INPUTS(iterations) {
+        Vec3 out = mul_vec3_f32(INPUTS.vec3s[0][i], INPUTS.f32s[1][i]);
+        KEEP(out);
+    }
+}
+
+static void bench_cross_vec3(u64 iterations) {
+    FOR_INPUTS(iterations) {
+        Vec3 out = cross_vec3(INPUTS.vec3s[0][i], INPUTS.vec3s[1][i]);
+        KEEP(out);
+    }
+}
+
+static void bench_dot_vec3(u64 iterations) {
+    FOR_INPUTS(iterations) {
+        f32 out = dot_vec3(INPUTS.vec3s[0][i], INPUTS.vec3s[1][i]);
+        KEEP(out);
+    }
+}
+
+static void bench_len_vec3(u64 iterations) {
+    FOR_INPUTS(iterations) {
+        f32 out = len_vec3(INPUTS.vec3s[0][i]);
+        KEEP(out);
+    }
+}
+
+static void bench_norm_vec3(u64 iterations) {
+    FOR_INPUTS(iterations) {
+        Vec3 out = norm_vec3(INPUTS.vec3s[0][i]);
+        KEEP(out);
+    }
+}
+
+static void bench_linear_combine(u64 iterations) {
+    FOR_INPUTS(iterations) {
+        Simd4f32 out =
+            linear_combine(INPUTS.mat4s[0][i].column[0], INPUTS.mat4s[1][i]);
+        KEEP(out);
+    }
+}
+
+static void bench_mul_mat4(u64 iterations) {
+    FOR_INPUTS(iterations) {
+        Mat4 out = mul_mat4(INPUTS.mat4s[0][i], INPUTS.mat4s[1][i]);
+        KEEP(out);
+    }
+}
+
+static void bench_rotate_mat4(u64 iterations) {
+    FOR_INPUTS(iterations) {
+        Mat4 out = rotate_mat4(INPUTS.f32s[0][i], INPUTS.vec3s[0][i]);
+        KEEP(out);
+    }
+}
+
+static void bench_trs_mat4(u64 iterations) {
+    FOR_INPUTS(iterations) {
+        Mat4 out = trs_mat4(INPUTS.vec3s[0][i],
+                            INPUTS.f32s[0][i],
+                            INPUTS.vec3s[1][i],
+                            INPUTS.vec3s[2][i]);
+        KEEP(out);
+    }
+}
+
+static void bench_perspective_mat4(u64 iterations) {
+    FOR_INPUTS(iterations) {
+        Mat4 out = perspective_mat4(INPUTS.f32s[1][i],
+                                    INPUTS.f32s[2][i],
+                                    INPUTS.f32s[3][i],
+                                    100.0f);
+        KEEP(out);
+    }
+}
+
+static void bench_look_at_mat4(u64 iterations) {
+    FOR_INPUTS(iterations) {
+        Mat4 out = look_at_mat4(INPUTS.vec3s[0][i],
+                                INPUTS.vec3s[1][i],
+                                INPUTS.vec3s[2][i]);
+        KEEP(out);
+    }
+}
+
+static void bench_update_particles(u64 iterations) {
+    for (u64 i = 0; i < iterations; ++i) {
+        update_particles(&PARTICLES, &PARTICLE_POOL, PARTICLE_DT);
+    }
+}
+
+static const Bench BENCHES[] = {
+    {"add_vec3", bench_add_vec3},
+    {"sub_vec3", bench_sub_vec3},
+    {"mul_vec3_f32", bench_mul_vec3_f32},
+    {"cross_vec3", bench_cross_vec3},
+    {"dot_vec3", bench_dot_vec3},
+    {"len_vec3", bench_len_vec3},
+    {"norm_vec3", bench_norm_vec3},
+    {"linear_combine", bench_linear_combine},
+    {"mul_mat4", bench_mul_mat4},
+    {"rotate_mat4", bench_rotate_mat4},
+    {"trs_mat4", bench_trs_mat4},
+    {"perspective_mat4", bench_perspective_mat4},
+    {"look_at_mat4", bench_look_at_mat4},
+};
+
+#define COUNT_BENCHES (sizeof(BENCHES) / sizeof(BENCHES[0]))
+
+static i32 compare_f64(const void* l, const void* r) {
+    f64 a = *(const f64*)l;
+    f64 b = *(const f64*)r;
+    return (a > b) - (a < b);
+}
+
+static Summary get_summary(Kernel kernel, u32 len) {
+    // NOTE: Grow the iteration count until one sample is long enough to be
+    // well above timer resolution; this doubles as the warmup.
+    u64 iterations = 1;
+    u64 start = get_nanoseconds();
+    for (;;) {
+        u64 before = get_nanoseconds();
+        kernel(iterations);
+        u64 elapsed = get_nanoseconds() - before;
+        if ((SAMPLE_NANOSECONDS <= elapsed) &&
+            (WARMUP_NANOSECONDS <= (get_nanoseconds() - start)))
+        {
+            break;
+        }
+        if (elapsed < SAMPLE_NANOSECONDS) {
+            iterations *= 2;
+        }
+    }
+    f64 samples[COUNT_SAMPLES];
+    f64 ops = (f64)iterations * len;
+    for (u32 i = 0; i < COUNT_SAMPLES; ++i) {
+        u64 before = get_nanoseconds();
+        kernel(iterations);
+        samples[i] = (f64)(get_nanoseconds() - before) / ops;
+    }
+    qsort(samples, COUNT_SAMPLES, sizeof(samples[0]), compare_f64);
+    Summary summary = {
+        .min = samples[0],
+        .median = samples[COUNT_SAMPLES / 2],
+        .max = samples[COUNT_SAMPLES - 1],
+        .ops = iterations * len,
+    };
+    for (u32 i = 0; i < COUNT_SAMPLES; ++i) {
+        summary.mean += samples[i];
+    }
+    summary.mean /= COUNT_SAMPLES;
+    for (u32 i = 0; i < COUNT_SAMPLES; ++i) {
+        f64 delta = samples[i] - summary.mean;
+        summary.stddev += delta * delta;
+    }
+    summary.stddev = sqrt(summary.stddev / (COUNT_SAMPLES - 1));
+    return summary;
+}
+
+// NOTE: Error in units of the `f32` ULP at `scale`. `scale` is the magnitude
+// the result is computed from (e.g. the sum of absolute products for a dot
+// product), so cancellation near zero is not mistaken for a large error.
+static f64 get_ulps(f32 value, f64 reference, f64 scale) {
+    f32 magnitude = (f32)fabs(scale);
+    if (magnitude < FLT_MIN) {
+        magnitude = FLT_MIN;
+    }
+    f64 ulp = (f64)(nextafterf(magnitude, INFINITY) - magnitude);
+    return fabs((f64)value - reference) / ulp;
+}
+
+static f64 get_ulps_vec3(Vec3 value, const f64* reference, const f64* scale) {
+    f64 ulps = get_ulps(value.x, reference[0], scale[0]);
+    ulps = fmax(ulps, get_ulps(value.y, reference[1], scale[1]));
+    return fmax(ulps, get_ulps(value.z, reference[2], scale[2]));
+}
+
+static f64 get_ulps_mat4(Mat4 value, f64 reference[4][4], f64 scale[4][4]) {
+    f64 ulps = 0.0;
+    for (u32 i = 0; i < 4; ++i) {
+        for (u32 j = 0; j < 4; ++j) {
+            ulps = fmax(ulps,
+                        get_ulps(value.cell[i][j],
+                                 reference[i][j],
+                                 scale[i][j]));
+        }
+    }
+    return ulps;
+}
+
+static void set_vec3_f64(Vec3 v, f64* out) {
+    out[0] = v.x;
+    out[1] = v.y;
+    out[2] = v.z;
+}
+
+static void set_cross_f64(const f64* l, const f64* r, f64* out, f64* scale) {
+    out[0] = (l[1] * r[2]) - (l[2] * r[1]);
+    out[1] = (l[2] * r[0]) - (l[0] * r[2]);
+    out[2] = (l[0] * r[1]) - (l[1] * r[0]);
+    scale[0] = fabs(l[1] * r[2]) + fabs(l[2] * r[1]);
+    scale[1] = fabs(l[2] * r[0]) + fabs(l[0] * r[2]);
+    scale[2] = fabs(l[0] * r[1]) + fabs(l[1] * r[0]);
+}
+
+static f64 get_dot_f64(const f64* l, const f64* r) {
+    return (l[0] * r[0]) + (l[1] * r[1]) + (l[2] * r[2]);
+}
+
+static void set_norm_f64(f64* v) {
+    f64 len = sqrt(get_dot_f64(v, v));
+    v[0] /= len;
+    v[1] /= len;
+    v[2] /= len;
+}
+
+static f64 check_vec3(u32 i) {
+    Vec3 l = INPUTS.vec3s[0][i];
+    Vec3 r = INPUTS.vec3s[1][i];
+    f64  a[3];
+    f64  b[3];
+    f64  reference[3];
+    f64  scale[3];
+    set_vec3_f64(l, a);
+    set_vec3_f64(r, b);
+    f64 ulps = 0.0;
+    for (u32 j = 0; j < 3; ++j) {
+        reference[j] = a[j] + b[j];
+        scale[j] = fmax(fabs(a[j]), fabs(b[j]));
+    }
+    ulps = fmax(ulps, get_ulps_vec3(add_vec3(l, r), reference, scale));
+    for (u32 j = 0; j < 3; ++j) {
+        reference[j] = a[j] - b[j];
+    }
+    ulps = fmax(ulps, get_ulps_vec3(sub_vec3(l, r), reference, scale));
+    f64 k = INPUTS.f32s[1][i];
+    for (u32 j = 0; j < 3; ++j) {
+        reference[j] = a[j] * k;
+        scale[j] = reference[j];
+    }
+    ulps = fmax(ulps,
+                get_ulps_vec3(mul_vec3_f32(l, INPUTS.f32s[1][i]),
+                              reference,
+                              scale));
+    return ulps;
+}
+
+static f64 check_cross_vec3(u32 i) {
+    f64 a[3];
+    f64 b[3];
+    f64 reference[3];
+    f64 scale[3];
+    set_vec3_f64(INPUTS.vec3s[0][i], a);
+    set_vec3_f64(INPUTS.vec3s[1][i], b);
+    set_cross_f64(a, b, reference, scale);
+    return get_ulps_vec3(cross_vec3(INPUTS.vec3s[0][i], INPUTS.vec3s[1][i]),
+                         reference,
+                         scale);
+}
+
+static f64 check_dot_vec3(u32 i) {
+    f64 a[3];
+    f64 b[3];
+    set_vec3_f64(INPUTS.vec3s[0][i], a);
+    set_vec3_f64(INPUTS.vec3s[1][i], b);
+    f64 scale = fabs(a[0] * b[0]) + fabs(a[1] * b[1]) + fabs(a[2] * b[2]);
+    return get_ulps(dot_vec3(INPUTS.vec3s[0][i], INPUTS.vec3s[1][i]),
+                    get_dot_f64(a, b),
+                    scale);
+}
+
+static f64 check_len_vec3(u32 i) {
+    f64 a[3];
+    set_vec3_f64(INPUTS.vec3s[0][i], a);
+    f64 reference = sqrt(get_dot_f64(a, a));
+    return get_ulps(len_vec3(INPUTS.vec3s[0][i]), reference, reference);
+}
+
+static f64 check_norm_vec3(u32 i) {
+    f64 a[3];
+    f64 scale[3] = {1.0, 1.0, 1.0};
+    set_vec3_f64(INPUTS.vec3s[0][i], a);
+    set_norm_f64(a);
+    return get_ulps_vec3(norm_vec3(INPUTS.vec3s[0][i]), a, scale);
+}
+
+static void set_mul_f64(Mat4 l, Mat4 r, f64 out[4][4], f64 scale[4][4]) {
+    for (u32 i = 0; i < 4; ++i) {
+        for (u32 j = 0; j < 4; ++j) {
+            out[i][j] = 0.0;
+            scale[i][j] = 0.0;
+            for (u32 k = 0; k < 4; ++k) {
+                f64 term = (f64)l.cell[k][j] * (f64)r.cell[i][k];
+                out[i][j] += term;
+                scale[i][j] += fabs(term);
+            }
+        }
+    }
+}
+
+static f64 check_linear_combine(u32 i) {
+    Mat4 l = {0};
+    l.column[0] = INPUTS.mat4s[0][i].column[0];
+    f64 reference[4][4];
+    f64 scale[4][4];
+    set_mul_f64(INPUTS.mat4s[1][i], l, reference, scale);
+    f32 out[4];
+    _mm_storeu_ps(out, linear_combine(l.column[0], INPUTS.mat4s[1][i]));
+    f64 ulps = 0.0;
+    for (u32 j = 0; j < 4; ++j) {
+        ulps = fmax(ulps, get_ulps(out[j], reference[0][j], scale[0][j]));
+    }
+    return ulps;
+}
+
+static f64 check_mul_mat4(u32 i) {
+    f64 reference[4][4];
+    f64 scale[4][4];
+    set_mul_f64(INPUTS.mat4s[0][i], INPUTS.mat4s[1][i], reference, scale);
+    return get_ulps_mat4(mul_mat4(INPUTS.mat4s[0][i], INPUTS.mat4s[1][i]),
+                         reference,
+                         scale);
+}
+
+static void set_rotate_f64(f64 radians, Vec3 axis, f64 out[4][4]) {
+    f64 a[3];
+    set_vec3_f64(axis, a);
+    set_norm_f64(a);
+    f64 s = sin(radians);
+    f64 c = cos(radians);
+    f64 d = 1.0 - c;
+    memset(out, 0, sizeof(f64) * 16);
+    out[0][0] = (a[0] * a[0] * d) + c;
+    out[0][1] = (a[0] * a[1] * d) + (a[2] * s);
+    out[0][2] = (a[0] * a[2] * d) - (a[1] * s);
+    out[1][0] = (a[0] * a[1] * d) - (a[2] * s);
+    out[1][1] = (a[1] * a[1] * d) + c;
+    out[1][2] = (a[1] * a[2] * d) + (a[0] * s);
+    out[2][0] = (a[0] * a[2] * d) + (a[1] * s);
+    out[2][1] = (a[1] * a[2] * d) - (a[0] * s);
+    out[2][2] = (a[2] * a[2] * d) + c;
+    out[3][3] = 1.0;
+}
+
+static f64 check_rotate_mat4(u32 i) {
+    f64 reference[4][4];
+    f64 scale[4][4];
+    set_rotate_f64(INPUTS.f32s[0][i], INPUTS.vec3s[0][i], reference);
+    for (u32 j = 0; j < 16; ++j) {
+        scale[j / 4][j % 4] = 1.0;
+    }
+    return get_ulps_mat4(rotate_mat4(INPUTS.f32s[0][i], INPUTS.vec3s[0][i]),
+                         reference,
+                         scale);
+}
+
+static f64 check_trs_mat4(u32 i) {
+    Vec3 t = INPUTS.vec3s[0][i];
+    Vec3 s = INPUTS.vec3s[2][i];
+    f64  reference[4][4];
+    f64  scale[4][4];
+    set_rotate_f64(INPUTS.f32s[0][i], INPUTS.vec3s[1][i], reference);
+    f64 k[3] = {s.x, s.y, s.z};
+    for (u32 j = 0; j < 3; ++j) {
+        for (u32 l = 0; l < 4; ++l) {
+            reference[j][l] *= k[j];
+            scale[j][l] = fabs(k[j]);
+        }
+    }
+    set_vec3_f64(t, reference[3]);
+    for (u32 l = 0; l < 4; ++l) {
+        scale[3][l] = fmax(fabs(reference[3][l]), 1.0);
+    }
+    return get_ulps_mat4(trs_mat4(t, INPUTS.f32s[0][i], INPUTS.vec3s[1][i], s),
+                         reference,
+                         scale);
+}
+
+static f64 check_perspective_mat4(u32 i) {
+    f64 fov = INPUTS.f32s[1][i];
+    f64 aspect = INPUTS.f32s[2][i];
+    f64 near = INPUTS.f32s[3][i];
+    f64 far = 100.0;
+    f64 cotangent = 1.0 / tan(fov / 2.0);
+    f64 reference[4][4] = {{0}};
+    reference[0][0] = cotangent / aspect;
+    reference[1][1] = cotangent;
+    reference[2][3] = -1.0;
+    reference[2][2] = (near + far) / (near - far);
+    reference[3][2] = (near * far * 2.0) / (near - far);
+    f64 scale[4][4];
+    for (u32 j = 0; j < 16; ++j) {
+        scale[j / 4][j % 4] = fabs(reference[j / 4][j % 4]);
+    }
+    return get_ulps_mat4(perspective_mat4(INPUTS.f32s[1][i],
+                                          INPUTS.f32s[2][i],
+                                          INPUTS.f32s[3][i],
+                                          100.0f),
+                         reference,
+                         scale);
+}
+
+static f64 check_look_at_mat4(u32 i) {
+    f64 eye[3];
+    f64 target[3];
+    f64 up[3];
+    set_vec3_f64(INPUTS.vec3s[0][i], eye);
+    set_vec3_f64(INPUTS.vec3s[1][i], target);
+    set_vec3_f64(INPUTS.vec3s[2][i], up);
+    f64 f[3] = {target[0] - eye[0], target[1] - eye[1], target[2] - eye[2]};
+    set_norm_f64(f);
+    f64 s[3];
+    f64 u[3];
+    f64 _[3];
+    set_cross_f64(f, up, s, _);
+    set_norm_f64(s);
+    set_cross_f64(s, f, u, _);
+    f64 reference[4][4];
+    f64 scale[4][4];
+    for (u32 j = 0; j < 3; ++j) {
+        reference[j][0] = s[j];
+        reference[j][1] = u[j];
+        reference[j][2] = -f[j];
+        reference[j][3] = 0.0;
+    }
+    reference[3][0] = -get_dot_f64(s, eye);
+    reference[3][1] = -get_dot_f64(u, eye);
+    reference[3][2] = get_dot_f64(f, eye);
+    reference[3][3] = 1.0;
+    for (u32 j = 0; j < 16; ++j) {
+        scale[j / 4][j % 4] = 1.0;
+    }
+    for (u32 j = 0; j < 3; ++j) {
+        f64* axis = j == 0 ? s : j == 1 ? u : f;
+        scale[3][j] = fabs(axis[0] * eye[0]) + fabs(axis[1] * eye[1]) +
+                      fabs(axis[2] * eye[2]);
+    }
+    return get_ulps_mat4(look_at_mat4(INPUTS.vec3s[0][i],
+                                      INPUTS.vec3s[1][i],
+                                      INPUTS.vec3s[2][i]),
+                         reference,
+                         scale);
+}
+
+typedef f64 (*Checker)(u32 i);
+
+typedef struct {
+    const char* name;
+    Checker     checker;
+    f64         bound;
+} Test;
+
+// NOTE: Bounds are in ULPs at the scale described in `get_ulps`. They leave
+// room for FMA contraction and libm `sinf`/`cosf`/`tanf`, but are tight
+// enough to catch a wrong index or a dropped term.
+static const Test TESTS[] = {
+    {"add_sub_mul_vec3", check_vec3, 1.0},
+    {"cross_vec3", check_cross_vec3, 2.0},
+    {"dot_vec3", check_dot_vec3, 3.0},
+    {"len_vec3", check_len_vec3, 3.0},
+    {"norm_vec3", check_norm_vec3, 4.0},
+    {"linear_combine", check_linear_combine, 4.0},
+    {"mul_mat4", check_mul_mat4, 4.0},
+    {"rotate_mat4", check_rotate_mat4, 8.0},
+    {"trs_mat4", check_trs_mat4, 12.0},
+    {"perspective_mat4", check_perspective_mat4, 8.0},
+    {"look_at_mat4", check_look_at_mat4, 32.0},
+};
+
+#define COUNT_TESTS (sizeof(TESTS) / sizeof(TESTS[0]))
+
+static void pin(u32 cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set)) {
+        fprintf(stderr, "Unable to pin to CPU %u\n", cpu);
+    }
+}
+
+i32 main(i32 n, const char** args) {
+    if ((1 < n) && !strcmp(args[1], "flags")) {
+        printf("%s\n", BENCH_FLAGS);
+        return EXIT_SUCCESS;
+    }
+    Bool        json = (1 < n) && !strcmp(args[1], "json");
+    const char* label = 2 < n ? args[2] : "";
+    const char* env_cpu = getenv("BENCH_CPU");
+    u32         cpu = env_cpu ? (u32)atoi(env_cpu) : 0;
+    pin(cpu);
+    set_inputs();
+    Check checks[COUNT_TESTS];
+    Bool  pass = TRUE;
+    for (u32 i = 0; i < COUNT_TESTS; ++i) {
+        f64 ulps = 0.0;
+        for (u32 j = 0; j < COUNT_CHECKS; ++j) {
+            ulps = fmax(ulps, TESTS[i].checker(j % COUNT_INPUTS));
+        }
+        checks[i].name = TESTS[i].name;
+        checks[i].ulps = ulps;
+        checks[i].bound = TESTS[i].bound;
+        if (TESTS[i].bound < ulps) {
+            pass = FALSE;
+        }
+    }
+    Summary summaries[COUNT_BENCHES];
+    for (u32 i = 0; i < COUNT_BENCHES; ++i) {
+        summaries[i] = get_summary(BENCHES[i].kernel, COUNT_INPUTS);
+    }
+    init_particles(&PARTICLES, PARTICLE_ARRAYS, PARTICLE_EMITTER);
+    PARTICLES.out = PARTICLE_OUT;
+    bench_update_particles(PARTICLE_WARMUP_FRAMES);
+    u32     len_particles = PARTICLES.len;
+    Summary particles = get_summary(bench_update_particles, len_particles);
+    if (json) {
+        printf("{\n"
+               "  \"label\": \"%s\",\n"
+               "  \"compiler\": \"%s\",\n"
+               "  \"flags\": \"%s\",\n"
+               "  \"cpu\": %u,\n"
+               "  \"pass\": %s,\n"
+               "  \"checks\": [\n",
+               label,
+               __VERSION__,
+               BENCH_FLAGS,
+               cpu,
+               pass ? "true" : "false");
+        for (u32 i = 0; i < COUNT_TESTS; ++i) {
+            printf("    {\"name\": \"%s\", \"max_ulps\": %.3f, "
+                   "\"bound\": %.1f, \"pass\": %s}%s\n",
+                   checks[i].name,
+                   checks[i].ulps,
+                   checks[i].bound,
+                   checks[i].ulps <= checks[i].bound ? "true" : "false",
+                   i + 1 < COUNT_TESTS ? "," : "");
+        }
+        printf("  ],\n"
+               "  \"benchmarks\": [\n");
+        for (u32 i = 0; i < COUNT_BENCHES; ++i) {
+            Summary summary = summaries[i];
+            printf("    {\"name\": \"%s\", \"ns_per_op\": {\"min\": %.4f, "
+                   "\"median\": %.4f, \"mean\": %.4f, \"stddev\": %.4f, "
+                   "\"max\": %.4f}, \"mops_per_s\": %.2f, \"samples\": %d, "
+                   "\"ops_per_sample\": %lu}%s\n",
+                   BENCHES[i].name,
+                   summary.min,
+                   summary.median,
+                   summary.mean,
+                   summary.stddev,
+                   summary.max,
+                   1000.0 / summary.median,
+                   COUNT_SAMPLES,
+                   summary.ops,
+                   i + 1 < COUNT_BENCHES ? "," : "");
+        }
+        printf("  ],\n"
+               "  \"particles\": {\"count\": %u, \"ns_per_particle\": "
+               "{\"min\": %.4f, \"median\": %.4f, \"mean\": %.4f, "
+               "\"stddev\": %.4f, \"max\": %.4f}, "
+               "\"particles_per_ms_per_core\": %.0f}\n"
+               "}\n",
+               len_particles,
+               particles.min,
+               particles.median,
+               particles.mean,
+               particles.stddev,
+               particles.max,
+               1000000.0 / particles.median);
+    } else {
+        printf("%-18s%12s%12s%8s\n", "check", "max ulps", "bound", "");
+        for (u32 i = 0; i < COUNT_TESTS; ++i) {
+            printf("%-18s%12.3f%12.1f%8s\n",
+                   checks[i].name,
+                   checks[i].ulps,
+                   checks[i].bound,
+                   checks[i].ulps <= checks[i].bound ? "ok" : "FAIL");
+        }
+        printf("\n%-18s%10s%10s%10s%10s%12s\n",
+               "bench",
+               "min",
+               "median",
+               "mean",
+               "stddev",
+               "Mops/s");
+        for (u32 i = 0; i < COUNT_BENCHES; ++i) {
+            Summary summary = summaries[i];
+            printf("%-18s%10.3f%10.3f%10.3f%10.3f%12.2f\n",
+                   BENCHES[i].name,
+                   summary.min,
+                   summary.median,
+                   summary.mean,
+                   summary.stddev,
+                   1000.0 / summary.median);
+        }
+        printf("%-18s%10.3f%10.3f%10.3f%10.3f%12.2f\n",
+               "update_particles",
+               particles.min,
+               particles.median,
+               particles.mean,
+               particles.stddev,
+               1000.0 / particles.median);
+        printf("\n(ns/op, pinned to CPU %u)\n"
+               "\n%.0f particles/ms/core (%u particles)\n",
+               cpu,
+               1000000.0 / particles.median,
+               len_particles);
+    }
+    return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,263 @@
+#ifndef __CLUSTER_H__
+#define __CLUSTER_H__
+
+#include "math.h"
+#include "pool.h"
+
+#include <string.h>
+
+// NOTE: Froxel grid; `x`/`y` tiles are uniform in screen space, `z` slices
+// are exponential in view-space depth between `near` and `far`.
+#define CLUSTER_X      16
+#define CLUSTER_Y      12
+#define CLUSTER_Z      24
+#define COUNT_CLUSTERS (CLUSTER_X * CLUSTER_Y * CLUSTER_Z)
+
+// NOTE: Must be a multiple of 4; lights are transformed four at a time.
+#define CAP_LIGHTS        4096
+#define CAP_LIGHT_INDICES (1 << 18)
+
+// NOTE: Layout of one light in the `GL_RGBA32F` texture buffer.
+typedef struct {
+    f32 position[3]; // NOTE: View-space.
+    f32 radius;
+    f32 color[3];
+    f32 _;
+} LightTexel;
+
+typedef struct {
+    f32        x[CAP_LIGHTS];
+    f32        y[CAP_LIGHTS];
+    f32        z[CAP_LIGHTS];
+    f32        radius[CAP_LIGHTS];
+    f32        phase[CAP_LIGHTS];
+    f32        view_x[CAP_LIGHTS];
+    f32        view_y[CAP_LIGHTS];
+    f32        depth[CAP_LIGHTS];
+    u32        slice_first[CAP_LIGHTS];
+    u32        slice_last[CAP_LIGHTS];
+    LightTexel texels[CAP_LIGHTS];
+    u32        len;
+} Lights;
+
+typedef struct {
+    u32 offset;
+    u32 count;
+} ClusterSpan;
+
+typedef struct {
+    Lights*     lights;
+    Mat4        view;
+    f32         time;
+    f32         amplitude;
+    f32         scale_x;
+    f32         scale_y;
+    f32         near;
+    f32         far;
+    f32         depth_scale;
+    f32         depth_bias;
+    f32         slices[CLUSTER_Z + 1];
+    ClusterSpan spans[COUNT_CLUSTERS];
+    u32         cursors[COUNT_CLUSTERS];
+    u32         indices[CAP_LIGHT_INDICES];
+    u32         cap_indices;
+    u32         len_indices;
+    u32         overflow;
+    Bool        fill;
+} Clusters;
+
+static u32 get_slice(const Clusters* clusters, f32 depth) {
+    i32 slice =
+        (i32)((logf(depth) * clusters->depth_scale) + clusters->depth_bias);
+    if (slice < 0) {
+        return 0;
+    }
+    if (CLUSTER_Z <= slice) {
+        return CLUSTER_Z - 1;
+    }
+    return (u32)slice;
+}
+
+static void set_cluster_projection(Clusters* clusters,
+                                   Mat4      projection,
+                                   f32       near,
+                                   f32       far) {
+    clusters->scale_x = projection.cell[0][0];
+    clusters->scale_y = projection.cell[1][1];
+    clusters->near = near;
+    clusters->far = far;
+    clusters->depth_scale = CLUSTER_Z / logf(far / near);
+    clusters->depth_bias = -logf(near) * clusters->depth_scale;
+    for (u32 i = 0; i <= CLUSTER_Z; ++i) {
+        clusters->slices[i] = near * powf(far / near, (f32)i / CLUSTER_Z);
+    }
+}
+
+// NOTE: Animates, then moves lights into view space four at a time, and
+// works out which depth slices each one can touch.
+static void set_lights_view(void* payload, u32 index, u32 count) {
+    Clusters* clusters = payload;
+    Lights*   lights = clusters->lights;
+    Chunk     chunk = get_chunk(lights->len / 4, index, count);
+    Mat4      view = clusters->view;
+    for (u32 i = chunk.begin * 4; i < chunk.end * 4; i += 4) {
+        Simd4f32 x = _mm_loadu_ps(&lights->x[i]);
+        Simd4f32 y = _mm_loadu_ps(&lights->y[i]);
+        Simd4f32 z = _mm_loadu_ps(&lights->z[i]);
+        const f32* phase = &lights->phase[i];
+        f32        t = clusters->time;
+        Simd4f32   bob = _mm_setr_ps(sinf(t + phase[0]),
+                                   sinf(t + phase[1]),
+                                   sinf(t + phase[2]),
+                                   sinf(t + phase[3]));
+        y = _mm_add_ps(y, _mm_mul_ps(bob, _mm_set1_ps(clusters->amplitude)));
+        Simd4f32 view_xyz[3];
+        for (u32 j = 0; j < 3; ++j) {
+            Simd4f32 out = _mm_set1_ps(view.cell[3][j]);
+            out = _mm_add_ps(out, _mm_mul_ps(x, _mm_set1_ps(view.cell[0][j])));
+            out = _mm_add_ps(out, _mm_mul_ps(y, _mm_set1_ps(view.cell[1][j])));
+            out = _mm_add_ps(out, _mm_mul_ps(z, _mm_set1_ps(view.cell[2][j])));
+            view_xyz[j] = out;
+        }
+        _mm_storeu_ps(&lights->view_x[i], view_xyz[0]);
+        _mm_storeu_ps(&lights->view_y[i], view_xyz[1]);
+        // NOTE: The camera looks down `-z`; positive depth is in front.
+        _mm_storeu_ps(&lights->depth[i],
+                      _mm_sub_ps(_mm_setzero_ps(), view_xyz[2]));
+        for (u32 j = i; j < (i + 4); ++j) {
+            f32         depth = lights->depth[j];
+            f32         radius = lights->radius[j];
+            LightTexel* texel = &lights->texels[j];
+            texel->position[0] = lights->view_x[j];
+            texel->position[1] = lights->view_y[j];
+            texel->position[2] = -depth;
+            texel->radius = radius;
+            if (((depth + radius) < clusters->near) ||
+                (clusters->far < (depth - radius)))
+            {
+                lights->slice_first[j] = 1;
+                lights->slice_last[j] = 0;
+                continue;
+            }
+            f32 near = depth - radius;
+            f32 far = depth + radius;
+            near = near < clusters->near ? clusters->near : near;
+            far = clusters->far < far ? clusters->far : far;
+            lights->slice_first[j] = get_slice(clusters, near);
+            lights->slice_last[j] = get_slice(clusters, far);
+        }
+    }
+}
+
+typedef struct {
+    u32 first;
+    u32 last;
+} TileRange;
+
+// NOTE: Conservative screen-space extent of `[center - radius, center +
+// radius]` over the depth range `[near, far]`, in tiles.
+static Bool get_tiles(f32        center,
+                      f32        radius,
+                      f32        scale,
+                      f32        near,
+                      f32        far,
+                      u32        tiles,
+                      TileRange* range) {
+    f32 low = center - radius;
+    f32 high = center + radius;
+    f32 ndc_low = (scale * low) / (low < 0.0f ? near : far);
+    f32 ndc_high = (scale * high) / (0.0f < high ? near : far);
+    if ((ndc_high < -1.0f) || (1.0f < ndc_low)) {
+        return FALSE;
+    }
+    i32 first = (i32)(((ndc_low * 0.5f) + 0.5f) * (f32)tiles);
+    i32 last = (i32)(((ndc_high * 0.5f) + 0.5f) * (f32)tiles);
+    range->first = first < 0 ? 0 : (u32)first;
+    range->last = (i32)tiles <= last ? tiles - 1 : (u32)last;
+    return TRUE;
+}
+
+// NOTE: Each thread owns a contiguous run of depth slices, so no two threads
+// ever touch the same cluster. Runs twice: once to count, once to fill.
+static void set_clusters(void* payload, u32 index, u32 count) {
+    Clusters* clusters = payload;
+    Lights*   lights = clusters->lights;
+    Chunk     chunk = get_chunk(CLUSTER_Z, index, count);
+    for (u32 z = chunk.begin; z < chunk.end; ++z) {
+        ClusterSpan* spans = &clusters->spans[z * CLUSTER_X * CLUSTER_Y];
+        u32*         cursors = &clusters->cursors[z * CLUSTER_X * CLUSTER_Y];
+        memset(cursors, 0, sizeof(u32) * CLUSTER_X * CLUSTER_Y);
+        f32 slice_near = clusters->slices[z];
+        f32 slice_far = clusters->slices[z + 1];
+        for (u32 i = 0; i < lights->len; ++i) {
+            if ((z < lights->slice_first[i]) || (lights->slice_last[i] < z)) {
+                continue;
+            }
+            f32 radius = lights->radius[i];
+            f32 near = lights->depth[i] - radius;
+            f32 far = lights->depth[i] + radius;
+            near = near < slice_near ? slice_near : near;
+            far = slice_far < far ? slice_far : far;
+            TileRange x;
+            TileRange y;
+            if (!get_tiles(lights->view_x[i],
+                           radius,
+                           clusters->scale_x,
+                           near,
+                           far,
+                           CLUSTER_X,
+                           &x) ||
+                !get_tiles(lights->view_y[i],
+                           radius,
+                           clusters->scale_y,
+                           near,
+                           far,
+                           CLUSTER_Y,
+                           &y))
+            {
+                continue;
+            }
+            for (u32 ty = y.first; ty <= y.last; ++ty) {
+                for (u32 tx = x.first; tx <= x.last; ++tx) {
+                    u32 cluster = (ty * CLUSTER_X) + tx;
+                    u32 cursor = cursors[cluster]++;
+                    if (clusters->fill && (cursor < spans[cluster].count)) {
+                        clusters->indices[spans[cluster].offset + cursor] = i;
+                    }
+                }
+            }
+        }
+        if (!clusters->fill) {
+            for (u32 i = 0; i < (CLUSTER_X * CLUSTER_Y); ++i) {
+                spans[i].count = cursors[i];
+            }
+        }
+    }
+}
+
+static void set_cluster_offsets(Clusters* clusters) {
+    u32 offset = 0;
+    clusters->overflow = 0;
+    for (u32 i = 0; i < COUNT_CLUSTERS; ++i) {
+        ClusterSpan* span = &clusters->spans[i];
+        u32          end = offset + span->count;
+        span->offset = offset;
+        if (clusters->cap_indices < end) {
+            clusters->overflow += end - clusters->cap_indices;
+            span->count = clusters->cap_indices - offset;
+        }
+        offset += span->count;
+    }
+    clusters->len_indices = offset;
+}
+
+static void update_clusters(Clusters* clusters, Pool* pool) {
+    run_pool(pool, set_lights_view, clusters);
+    clusters->fill = FALSE;
+    run_pool(pool, set_clusters, clusters);
+    set_cluster_offsets(clusters);
+    clusters->fill = TRUE;
+    run_pool(pool, set_clusters, clusters);
+}
+
+#endif
@@ -0,0 +1,196 @@
+#ifndef __DEBUG_H__
+#define __DEBUG_H__
+
+// NOTE: Everything here compiles to nothing unless built with `-DDEBUG`.
+
+#ifdef DEBUG
+
+    #include "prelude.h"
+
+    #include <stdatomic.h>
+    #include <stdlib.h>
+    #include <string.h>
+
+    // NOTE: Must be a power of two.
+    #define CAP_DEBUG_MESSAGES 64
+    #define SIZE_DEBUG_MESSAGE 256
+
+typedef struct {
+    atomic_uint sequence;
+    GLenum      source;
+    GLenum      type;
+    GLenum      severity;
+    u32         id;
+    char        text[SIZE_DEBUG_MESSAGE];
+} DebugMessage;
+
+// NOTE: Bounded multi-producer, single-consumer ring. Without
+// `GL_DEBUG_OUTPUT_SYNCHRONOUS` the driver may call back from its own
+// threads, so producers claim slots with a CAS on `tail` and publish them
+// through each slot's `sequence`; the render thread drains in order.
+typedef struct {
+    DebugMessage messages[CAP_DEBUG_MESSAGES];
+    atomic_uint  tail;
+    u32          head;
+    atomic_uint  dropped;
+} DebugLog;
+
+static DebugLog DEBUG_LOG;
+
+static void GLAPIENTRY debug_callback(GLenum        source,
+                                      GLenum        type,
+                                      GLuint        id,
+                                      GLenum        severity,
+                                      GLsizei       length,
+                                      const GLchar* text,
+                                      const void*   _) {
+    u32 tail = atomic_load_explicit(&DEBUG_LOG.tail, memory_order_relaxed);
+    DebugMessage* message;
+    for (;;) {
+        message = &DEBUG_LOG.messages[tail & (CAP_DEBUG_MESSAGES - 1)];
+        u32 sequence =
+            atomic_load_explicit(&message->sequence, memory_order_acquire);
+        i32 diff = (i32)(sequence - tail);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&DEBUG_LOG.tail,
+                                                      &tail,
+                                                      tail + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+            {
+                break;
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&DEBUG_LOG.dropped,
+                                      1,
+                                      memory_order_relaxed);
+            return;
+        } else {
+            tail = atomic_load_explicit(&DEBUG_LOG.tail, memory_order_relaxed);
+        }
+    }
+    message->source = source;
+    message->type = type;
+    message->severity = severity;
+    message->id = id;
+    usize size = length < 0 ? strlen(text) : (usize)length;
+    if (SIZE_DEBUG_MESSAGE <= size) {
+        size = SIZE_DEBUG_MESSAGE - 1;
+    }
+    memcpy(message->text, text, size);
+    message->text[size] = '\0';
+    atomic_store_explicit(&message->sequence, tail + 1, memory_order_release);
+}
+
+static void init_debug(void) {
+    for (u32 i = 0; i < CAP_DEBUG_MESSAGES; ++i) {
+        atomic_init(&DEBUG_LOG.messages[i].sequence, i);
+    }
+    atomic_init(&DEBUG_LOG.tail, 0);
+    atomic_init(&DEBUG_LOG.dropped, 0);
+    DEBUG_LOG.head = 0;
+    if (!glfwExtensionSupported("GL_KHR_debug")) {
+        fprintf(stderr, "GL_KHR_debug unavailable\n");
+        return;
+    }
+    glEnable(GL_DEBUG_OUTPUT);
+    glDebugMessageCallback(debug_callback, NULL);
+    glDebugMessageControl(GL_DONT_CARE,
+                          GL_DONT_CARE,
+                          GL_DEBUG_SEVERITY_NOTIFICATION,
+                          0,
+                          NULL,
+                          GL_FALSE);
+}
+
+// NOTE: Called once per frame from the render thread; errors stay fatal, as
+// they were with `glGetError` polling.
+static void flush_debug(void) {
+    Bool fatal = FALSE;
+    for (;;) {
+        DebugMessage* message =
+            &DEBUG_LOG.messages[DEBUG_LOG.head & (CAP_DEBUG_MESSAGES - 1)];
+        u32 sequence =
+            atomic_load_explicit(&message->sequence, memory_order_acquire);
+        if (sequence != (DEBUG_LOG.head + 1)) {
+            break;
+        }
+        fprintf(stderr,
+                "GL [0x%X:0x%X:0x%X:%u] %s\n",
+                message->source,
+                message->type,
+                message->severity,
+                message->id,
+                message->text);
+        if (message->type == GL_DEBUG_TYPE_ERROR) {
+            fatal = TRUE;
+        }
+        atomic_store_explicit(&message->sequence,
+                              DEBUG_LOG.head + CAP_DEBUG_MESSAGES,
+                              memory_order_release);
+        ++DEBUG_LOG.head;
+    }
+    u32 dropped =
+        atomic_exchange_explicit(&DEBUG_LOG.dropped, 0, memory_order_relaxed);
+    if (dropped != 0) {
+        fprintf(stderr, "GL [dropped %u message(s)]\n", dropped);
+    }
+    if (fatal) {
+        ERROR("GL_DEBUG_TYPE_ERROR");
+    }
+}
+
+static const char* get_gl_error(void) {
+    switch (glGetError()) {
+    case GL_INVALID_ENUM: {
+        return "GL_INVALID_ENUM";
+    }
+    case GL_INVALID_VALUE: {
+        return "GL_INVALID_VALUE";
+    }
+    case GL_INVALID_OPERATION: {
+        return "GL_INVALID_OPERATION";
+    }
+    case GL_INVALID_FRAMEBUFFER_OPERATION: {
+        return "GL_INVALID_FRAMEBUFFER_OPERATION";
+    }
+    case GL_OUT_OF_MEMORY: {
+        return "GL_OUT_OF_MEMORY";
+    }
+    default: {
+        return NULL;
+    }
+    }
+}
+
+    // NOTE: Synchronous; only for one-off setup code, never the frame loop.
+    #define CHECK_GL_ERROR()                    \
+        {                                       \
+            const char* error = get_gl_error(); \
+            if (error) {                        \
+                ERROR(error);                   \
+            }                                   \
+        }
+
+    #define INIT_DEBUG()  init_debug()
+    #define FLUSH_DEBUG() flush_debug()
+
+    #define LABEL_DEBUG(type, name, label) \
+        glObjectLabel(type, name, -1, label)
+
+    #define PUSH_DEBUG(label) \
+        glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, label)
+    #define POP_DEBUG() glPopDebugGroup()
+
+#else
+
+    #define CHECK_GL_ERROR()
+    #define INIT_DEBUG()
+    #define FLUSH_DEBUG()
+    #define LABEL_DEBUG(type, name, label)
+    #define PUSH_DEBUG(label)
+    #define POP_DEBUG()
+
+#endif
+
+#endif
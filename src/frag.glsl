@@ -3,9 +3,49 @@
 precision mediump float;
 
 in vec3 VERT_OUT_COLOR;
+in vec3 VERT_OUT_VIEW;
 
-#define K 5
+// NOTE: Two texels per light; `(view_position, radius)`, `(color, _)`.
+uniform samplerBuffer U_LIGHTS;
+// NOTE: One `(offset, count)` pair per cluster into `U_LIGHT_INDICES`.
+uniform usamplerBuffer U_CLUSTERS;
+uniform usamplerBuffer U_LIGHT_INDICES;
+
+uniform ivec3 U_CLUSTER_SIZE;
+// NOTE: Clusters are binned for the primary view only.
+uniform mat4 U_PROJECTION;
+// NOTE: `slice = log(depth) * U_CLUSTER_DEPTH.x + U_CLUSTER_DEPTH.y`
+uniform vec2 U_CLUSTER_DEPTH;
+
+#define K       5
+#define AMBIENT 0.35
 
 void main() {
-    gl_FragColor = vec4(round(VERT_OUT_COLOR * K) / K, 1.0);
+    // NOTE: The cube mesh carries no normals; the face normal falls out of
+    // the screen-space derivatives of the view-space position.
+    vec3  normal = normalize(cross(dFdx(VERT_OUT_VIEW), dFdy(VERT_OUT_VIEW)));
+    // NOTE: `gl_FragCoord` is relative to whichever view's tile this
+    // fragment landed in, so find the cluster by re-projecting into the
+    // primary view instead. Fragments outside it clamp to the nearest edge.
+    vec4  clip = U_PROJECTION * vec4(VERT_OUT_VIEW, 1.0);
+    ivec3 cluster = ivec3(
+        ivec2(((clip.xy / clip.w) * 0.5 + 0.5) * vec2(U_CLUSTER_SIZE.xy)),
+        int(log(-VERT_OUT_VIEW.z) * U_CLUSTER_DEPTH.x + U_CLUSTER_DEPTH.y));
+    cluster = clamp(cluster, ivec3(0), U_CLUSTER_SIZE - 1);
+    uvec2 span = texelFetch(U_CLUSTERS,
+                            (cluster.z * U_CLUSTER_SIZE.y + cluster.y) *
+                                    U_CLUSTER_SIZE.x +
+                                cluster.x)
+                     .xy;
+    vec3 light = vec3(AMBIENT);
+    for (uint i = 0u; i < span.y; ++i) {
+        int   j = int(texelFetch(U_LIGHT_INDICES, int(span.x + i)).x);
+        vec4  position = texelFetch(U_LIGHTS, 2 * j);
+        vec3  delta = position.xyz - VERT_OUT_VIEW;
+        float dist = length(delta);
+        float falloff = max(1.0 - (dist / position.w), 0.0);
+        light += texelFetch(U_LIGHTS, (2 * j) + 1).rgb *
+            max(dot(normal, delta / dist), 0.0) * falloff * falloff;
+    }
+    gl_FragColor = vec4(round(VERT_OUT_COLOR * light * K) / K, 1.0);
 }
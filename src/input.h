@@ -0,0 +1,90 @@
+#ifndef __INPUT_H__
+#define __INPUT_H__
+
+#include "prelude.h"
+
+typedef enum {
+    EVENT_KEY,
+    EVENT_CURSOR,
+    EVENT_RESIZE,
+    EVENT_REFRESH,
+    EVENT_ICONIFY,
+} EventTag;
+
+typedef struct {
+    i32 key;
+    i32 action;
+} EventKey;
+
+typedef struct {
+    f32 x;
+    f32 y;
+} EventCursor;
+
+typedef struct {
+    i32 width;
+    i32 height;
+} EventResize;
+
+typedef union {
+    EventKey    key;
+    EventCursor cursor;
+    EventResize resize;
+    Bool        iconified;
+} EventBody;
+
+typedef struct {
+    EventBody body;
+    EventTag  tag;
+} Event;
+
+// NOTE: Must be a power of two.
+#define CAP_EVENTS 256
+
+// NOTE: Callbacks and consumer both run on the main thread (inside
+// `glfwPollEvents`/`glfwWaitEvents...` and the update step, respectively), so
+// the queue needs no synchronization.
+typedef struct {
+    Event buffer[CAP_EVENTS];
+    u32   head;
+    u32   tail;
+    u32   dropped;
+} Events;
+
+static u32 len_events(const Events* events) {
+    return events->tail - events->head;
+}
+
+static Event* get_event(Events* events, u32 index) {
+    return &events->buffer[index & (CAP_EVENTS - 1)];
+}
+
+static void push_event(Events* events, Event event) {
+    // NOTE: Consecutive cursor (or resize) events are coalesced; only the
+    // latest position matters to the update step, and a burst of mouse motion
+    // should not be able to push key events out of the queue.
+    if (len_events(events) != 0) {
+        Event* last = get_event(events, events->tail - 1);
+        if ((last->tag == event.tag) &&
+            ((event.tag == EVENT_CURSOR) || (event.tag == EVENT_RESIZE)))
+        {
+            *last = event;
+            return;
+        }
+    }
+    if (len_events(events) == CAP_EVENTS) {
+        ++events->dropped;
+        return;
+    }
+    *get_event(events, events->tail++) = event;
+}
+
+static Bool pop_event(Events* events, Event* event) {
+    if (len_events(events) == 0) {
+        return FALSE;
+    }
+    *event = *get_event(events, events->head++);
+    return TRUE;
+}
+
+#endif
@@ -1,6 +1,14 @@
+#include "cluster.h"
+#include "input.h"
 #include "math.h"
+#include "particle.h"
+#include "scene.h"
+#include "sort.h"
+#include "telemetry.h"
+#include "world.h"
 
 #include <string.h>
+#include <sys/resource.h>
 #include <unistd.h>
 
 #define GL_GLEXT_PROTOTYPES
@@ -15,12 +23,14 @@
 #include <GLFW/glfw3native.h>
 #include <X11/extensions/Xfixes.h>
 
+#include "debug.h"
+
 typedef struct {
     Display* display;
     Window   window;
 } Native;
 
-#define SIZE_BUFFER 1024
+#define SIZE_BUFFER 4096
 
 typedef struct {
     char buffer[SIZE_BUFFER];
@@ -31,19 +41,36 @@ typedef struct {
     i32 time;
     i32 projection;
     i32 view;
-    i32 transform;
+    i32 lights;
+    i32 clusters;
+    i32 light_indices;
+    i32 cluster_size;
+    i32 cluster_depth;
+    i32 view_projections;
+    i32 view_first;
+    i32 view_count;
+    i32 view_tiles;
 } Uniforms;
 
 typedef struct {
     f32 time;
 } State;
 
+typedef enum {
+    KEY_FORWARD = 1 << 0,
+    KEY_BACK = 1 << 1,
+    KEY_LEFT = 1 << 2,
+    KEY_RIGHT = 1 << 3,
+} Key;
+
+// NOTE: Absolute times are kept in `f64`; as `f32` microseconds they would
+// be down to 256us steps after an hour. Only deltas are narrowed.
 typedef struct {
-    f32 time;
-    f32 prev;
+    f64 time;
+    f64 prev;
+    f64 rendered;
     f32 delta;
-    f32 fps_time;
-    u8  fps_count;
+    u64 count;
 } Frame;
 
 #define MICROSECONDS 1000000.0f
@@ -53,6 +80,10 @@ typedef struct {
 static const f32 FRAME_DURATION = (1.0f / 60.0f) * MICROSECONDS;
 static const f32 FRAME_UPDATE_STEP = FRAME_DURATION / FRAME_UPDATE_COUNT;
 
+// NOTE: Upper bound on how long `glfwWaitEventsTimeout` blocks when nothing
+// needs to be drawn. Idle wake-ups do not render or record telemetry.
+#define IDLE_TIMEOUT 1.0
+
 #define INIT_WINDOW_WIDTH  1024
 #define INIT_WINDOW_HEIGHT 768
 
@@ -105,10 +136,13 @@ static const f32 COORDS[] = {
 
 static u8 COUNT_COORDS = sizeof(COORDS) / sizeof(COORDS[0]);
 
-// NOTE: `COUNT_TRANSLATIONS == (COUNT_COORDS * COUNT_COORDS)`
-#define COUNT_TRANSLATIONS 64
+static Scene SCENE;
+static u32   SCENE_ROOT;
+// NOTE: One node per column of the grid; every other column sways, so only
+// those subtrees are recomputed each frame.
+static u32 SCENE_COLUMNS[sizeof(COORDS) / sizeof(COORDS[0])];
 
-static Mat4 TRANSLATIONS[COUNT_TRANSLATIONS];
+static const f32 COLUMN_AMPLITUDE = 0.5f;
 
 static Mat4       MODEL;
 static const f32  MODEL_DEGREES = 15.0f;
@@ -144,13 +178,23 @@ static const Vec3 VIEW_UP = {
 
 #define KEY_SENSITIVITY 0.01f
 
-static f32 CURSOR_X;
-static f32 CURSOR_Y;
+static Events EVENTS;
+static u32    KEYS_HELD = 0;
+
+static f32  CURSOR_X;
+static f32  CURSOR_Y;
+static Bool CURSOR_INIT = FALSE;
 
 #define CURSOR_SENSITIVITY 0.1f
 
-static f32 CURSOR_X_DELTA = 0.0f;
-static f32 CURSOR_Y_DELTA = 0.0f;
+// NOTE: When `RENDER_ON_DEMAND` is set, frames are only drawn if something
+// visible changed since the last one; otherwise the loop blocks on events.
+// The time-driven animation changes every frame, so the loop only goes idle
+// once it is paused (SPACE) and nothing else moves.
+static Bool RENDER_ON_DEMAND = TRUE;
+static Bool RENDER_PAUSED = FALSE;
+static Bool RENDER_DIRTY = TRUE;
+static Bool WINDOW_ICONIFIED = FALSE;
 
 #define VIEW_NEAR 0.1f
 #define VIEW_FAR  100.0f
@@ -162,24 +206,153 @@ static f32 VIEW_PITCH = 0.0f;
 
 static Mat4 PROJECTION;
 
-static Mat4       TRANSFORM;
-static const Vec3 TRANSFORM_AXIS = {
+// NOTE: Views are spread along the camera's right axis (a stereo pair, or
+// split-screen past that) and drawn into side-by-side tiles of `FBO`. With
+// `VIEW_SINGLE_PASS` every view comes out of the same instanced draws;
+// otherwise the whole scene is submitted once per view.
+#define CAP_VIEWS 4
+
+static u32  VIEW_COUNT = 1;
+static Bool VIEW_SINGLE_PASS = TRUE;
+static u32  VIEW_DIVISOR = 1;
+static Mat4 VIEW_PROJECTIONS[CAP_VIEWS];
+
+static const f32 VIEW_SEPARATION = 0.35f;
+
+static Animation ANIMATIONS[CAP_INSTANCES];
+
+static const f32  ANIMATION_DEGREES = 25.0f;
+static const f32  ANIMATION_AMPLITUDE = 0.25f;
+static const Vec3 ANIMATION_AXIS = {
     .x = 0.0f,
     .y = 1.0f,
     .z = 0.0f,
 };
 
 static u32 VAO;
+static u32 PAO;
 static u32 VBO;
 static u32 EBO;
 static u32 IBO;
+static u32 ABO;
+static u32 SBO;
+static u32 WAO;
+static u32 WBO;
 static u32 FBO;
 static u32 RBO;
 static u32 DBO;
+static u32 LBO;
+static u32 CBO;
+static u32 XBO;
+static u32 LTO;
+static u32 CTO;
+static u32 XTO;
+
+static Pool POOL;
+
+// NOTE: Point lights are binned into `CLUSTERS` on the CPU every frame; the
+// fragment shader only walks the lights of the cluster it falls in.
+#define COUNT_LIGHTS 4096
+
+static Lights   LIGHTS;
+static Clusters CLUSTERS;
+
+static const f32  LIGHT_AMPLITUDE = 0.75f;
+static const f32  LIGHT_INTENSITY = 0.35f;
+static const f32  LIGHT_RADIUS_MIN = 1.0f;
+static const f32  LIGHT_RADIUS_MAX = 2.5f;
+static const Vec3 LIGHT_EXTENT = {
+    .x = 12.0f,
+    .y = 12.0f,
+    .z = 3.0f,
+};
+
+// NOTE: Particles share the cube mesh and its instanced draw; their state
+// lives on the CPU and is written straight into the mapped `SBO` (streamed
+// every frame) by the worker threads.
+static Bool           PARTICLES_ENABLED = TRUE;
+static Particles      PARTICLES;
+static ParticleArrays PARTICLE_ARRAYS[2];
+
+static const f32     PARTICLE_DT_MAX = 0.1f;
+static const Emitter PARTICLE_EMITTER = {
+    .origin = {.x = 0.0f, .y = -10.0f, .z = 3.0f},
+    .radius = 0.25f,
+    .spread = 2.5f,
+    .speed_min = 10.0f,
+    .speed_max = 15.0f,
+    .life_min = 1.0f,
+    .life_max = 3.0f,
+    .rate = (f32)CAP_PARTICLES * 0.45f,
+    .gravity = -9.8f,
+    .size = 0.06f,
+};
+
+// NOTE: Optional; streamed in chunks around `VIEW_EYE` from a file written
+// by `bin/world` (see `world.h`). Each resident chunk owns one fixed-size
+// slot of `WBO`.
+static Bool  WORLD_ENABLED = FALSE;
+static World WORLD;
+static u32   WORLD_SLOT_CHUNKS[CAP_WORLD_SLOTS];
+static u32   WORLD_FREE[CAP_WORLD_SLOTS];
+static u32   WORLD_LEN_FREE = 0;
+static u32   WORLD_LEN_RESIDENT = 0;
+static u64   WORLD_DRAWS[CAP_WORLD_SLOTS];
+static u32   WORLD_LEN_DRAWS = 0;
+static u64   WORLD_UPLOADED = 0;
+
+// NOTE: Seconds per frame the render thread may spend copying chunks.
+static const f64 WORLD_BUDGET = 0.001;
+
+static const u32 UNIT_LIGHTS = 0;
+static const u32 UNIT_CLUSTERS = 1;
+static const u32 UNIT_LIGHT_INDICES = 2;
+
+// NOTE: Instances are re-ordered front-to-back every frame so that depth
+// testing rejects hidden fragments before they are shaded.
+#define SORT_DEPTH_BITS 24
+
+static Bool      SORT_ENABLED = TRUE;
+static Sort      SORT;
+static u32       SORT_KEYS[2][CAP_INSTANCES];
+static u32       SORT_VALUES[2][CAP_INSTANCES];
+static u32       SORT_ORDER[CAP_INSTANCES];
+static Mat4      SORTED_INSTANCES[CAP_INSTANCES];
+static Animation SORTED_ANIMATIONS[CAP_INSTANCES];
+
+// NOTE: Latched whenever `update_scene` touches an instance and cleared only
+// once `set_instances` uploads, so changes made on frames that are never
+// drawn still reach `IBO`.
+static Bool INSTANCES_DIRTY = FALSE;
+
+// NOTE: `GL_SAMPLES_PASSED`, `GL_TIME_ELAPSED` and `GL_PRIMITIVES_GENERATED`
+// queries are ring-buffered and read back a few frames late so that the
+// counters never stall the pipeline.
+#define COUNT_QUERIES 4
+
+static u32 QUERIES[COUNT_QUERIES];
+static u32 TIMERS[COUNT_QUERIES];
+static u32 COUNTERS[COUNT_QUERIES];
+static u32 QUERY_INDEX = 0;
+static u32 SAMPLES = 0;
+static u32 GPU_NANOSECONDS = 0;
+static u32 PRIMITIVES = 0;
+static u32 DRAW_CALLS = 0;
+
+// NOTE: Frame stats go to a shared-memory ring (see `telemetry.h`) for
+// `bin/reader` to pick up; the frame thread never touches the terminal.
+static Telemetry*      TELEMETRY;
+static TelemetryRecord RECORD;
+static u64             GPU_BYTES = 0;
 
 static const u32 INDEX_POSITION = 0;
 static const u32 INDEX_COLOR = 1;
 static const u32 INDEX_TRANSLATE = 2;
+static const u32 INDEX_SPIN = 6;
+static const u32 INDEX_WAVE = 7;
+// NOTE: `x`, `y`, `z`, `size`; only bound in `PAO`, so they may overlap the
+// cube's per-instance locations.
+static const u32 INDEX_PARTICLE = 2;
 
 static void hide_cursor(Native native) {
     XFixesHideCursor(native.display, native.window);
@@ -191,102 +364,205 @@ static void show_cursor(Native native) {
     XFlush(native.display);
 }
 
-#define CHECK_GL_ERROR()                               \
-    {                                                  \
-        switch (glGetError()) {                        \
-        case GL_INVALID_ENUM: {                        \
-            ERROR("GL_INVALID_ENUM");                  \
-        }                                              \
-        case GL_INVALID_VALUE: {                       \
-            ERROR("GL_INVALID_VALUE");                 \
-        }                                              \
-        case GL_INVALID_OPERATION: {                   \
-            ERROR("GL_INVALID_OPERATION");             \
-        }                                              \
-        case GL_INVALID_FRAMEBUFFER_OPERATION: {       \
-            ERROR("GL_INVALID_FRAMEBUFFER_OPERATION"); \
-        }                                              \
-        case GL_OUT_OF_MEMORY: {                       \
-            ERROR("GL_OUT_OF_MEMORY");                 \
-        }                                              \
-        case GL_NO_ERROR: {                            \
-            break;                                     \
-        }                                              \
-        }                                              \
+#define NORM_CROSS(a, b) norm_vec3(cross_vec3(a, b))
+
+static void key_callback(GLFWwindow* _,
+                         i32         key,
+                         i32         scancode,
+                         i32         action,
+                         i32         mods) {
+    if (action == GLFW_REPEAT) {
+        return;
     }
+    Event event = {
+        .tag = EVENT_KEY,
+        .body.key = {.key = key, .action = action},
+    };
+    push_event(&EVENTS, event);
+}
 
-#define NORM_CROSS(a, b) norm_vec3(cross_vec3(a, b))
+static void cursor_callback(GLFWwindow* _, f64 x, f64 y) {
+    Event event = {
+        .tag = EVENT_CURSOR,
+        .body.cursor = {.x = (f32)x, .y = (f32)y},
+    };
+    push_event(&EVENTS, event);
+}
 
-static void set_input(GLFWwindow* window) {
-    glfwPollEvents();
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+static void framebuffer_size_callback(GLFWwindow* _, i32 width, i32 height) {
+    Event event = {
+        .tag = EVENT_RESIZE,
+        .body.resize = {.width = width, .height = height},
+    };
+    push_event(&EVENTS, event);
+}
+
+static void refresh_callback(GLFWwindow* _) {
+    Event event = {.tag = EVENT_REFRESH};
+    push_event(&EVENTS, event);
+}
+
+static void iconify_callback(GLFWwindow* _, i32 iconified) {
+    Event event = {
+        .tag = EVENT_ICONIFY,
+        .body.iconified = iconified ? TRUE : FALSE,
+    };
+    push_event(&EVENTS, event);
+}
+
+static u32 get_key(i32 key) {
+    switch (key) {
+    case GLFW_KEY_W: {
+        return KEY_FORWARD;
+    }
+    case GLFW_KEY_S: {
+        return KEY_BACK;
+    }
+    case GLFW_KEY_A: {
+        return KEY_LEFT;
+    }
+    case GLFW_KEY_D: {
+        return KEY_RIGHT;
+    }
+    default: {
+        return 0;
+    }
+    }
+}
+
+static void set_key(GLFWwindow* window, EventKey event) {
+    if (event.action == GLFW_RELEASE) {
+        KEYS_HELD &= ~get_key(event.key);
+        return;
+    }
+    switch (event.key) {
+    case GLFW_KEY_ESCAPE: {
         glfwSetWindowShouldClose(window, TRUE);
+        break;
+    }
+    case GLFW_KEY_SPACE: {
+        RENDER_PAUSED = !RENDER_PAUSED;
+        break;
+    }
+    case GLFW_KEY_TAB: {
+        RENDER_ON_DEMAND = !RENDER_ON_DEMAND;
+        break;
+    }
+    case GLFW_KEY_Z: {
+        SORT_ENABLED = !SORT_ENABLED;
+        break;
+    }
+    case GLFW_KEY_P: {
+        PARTICLES_ENABLED = !PARTICLES_ENABLED;
+        break;
     }
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+    case GLFW_KEY_V: {
+        VIEW_COUNT = (VIEW_COUNT % CAP_VIEWS) + 1;
+        break;
+    }
+    case GLFW_KEY_M: {
+        VIEW_SINGLE_PASS = !VIEW_SINGLE_PASS;
+        break;
+    }
+    default: {
+        KEYS_HELD |= get_key(event.key);
+    }
+    }
+}
+
+static void set_cursor(EventCursor event) {
+    if (!CURSOR_INIT) {
+        CURSOR_X = event.x;
+        CURSOR_Y = event.y;
+        CURSOR_INIT = TRUE;
+        return;
+    }
+    VIEW_YAW += (event.x - CURSOR_X) * CURSOR_SENSITIVITY;
+    VIEW_PITCH += (CURSOR_Y - event.y) * CURSOR_SENSITIVITY;
+    CURSOR_X = event.x;
+    CURSOR_Y = event.y;
+    if (PITCH_LIMIT < VIEW_PITCH) {
+        VIEW_PITCH = PITCH_LIMIT;
+    } else if (VIEW_PITCH < -PITCH_LIMIT) {
+        VIEW_PITCH = -PITCH_LIMIT;
+    }
+    VIEW_TARGET.x =
+        cosf(get_radians(VIEW_YAW)) * cosf(get_radians(VIEW_PITCH));
+    VIEW_TARGET.y = sinf(get_radians(VIEW_PITCH));
+    VIEW_TARGET.z =
+        sinf(get_radians(VIEW_YAW)) * cosf(get_radians(VIEW_PITCH));
+    VIEW_TARGET = norm_vec3(VIEW_TARGET);
+}
+
+static void set_input(GLFWwindow* window) {
+    Event event;
+    while (pop_event(&EVENTS, &event)) {
+        switch (event.tag) {
+        case EVENT_KEY: {
+            set_key(window, event.body.key);
+            break;
+        }
+        case EVENT_CURSOR: {
+            set_cursor(event.body.cursor);
+            break;
+        }
+        case EVENT_RESIZE: {
+            WINDOW_WIDTH = event.body.resize.width;
+            WINDOW_HEIGHT = event.body.resize.height;
+            break;
+        }
+        case EVENT_REFRESH: {
+            break;
+        }
+        case EVENT_ICONIFY: {
+            WINDOW_ICONIFIED = event.body.iconified;
+            break;
+        }
+        }
+        // NOTE: Every event we listen for changes something on screen.
+        RENDER_DIRTY = TRUE;
+    }
+    // NOTE: A full queue may have eaten a key release; let go of every key
+    // rather than leave the camera drifting.
+    if (EVENTS.dropped != 0) {
+        fprintf(stderr, "Input [dropped %u event(s)]\n", EVENTS.dropped);
+        EVENTS.dropped = 0;
+        KEYS_HELD = 0;
+    }
+}
+
+static void set_movement(void) {
+    if (KEYS_HELD & KEY_FORWARD) {
         VIEW_EYE = sub_vec3(
             VIEW_EYE,
             mul_vec3_f32(NORM_CROSS(cross_vec3(VIEW_TARGET, VIEW_UP), VIEW_UP),
                          KEY_SENSITIVITY));
     }
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+    if (KEYS_HELD & KEY_BACK) {
         VIEW_EYE = add_vec3(
             VIEW_EYE,
             mul_vec3_f32(NORM_CROSS(cross_vec3(VIEW_TARGET, VIEW_UP), VIEW_UP),
                          KEY_SENSITIVITY));
     }
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+    if (KEYS_HELD & KEY_LEFT) {
         VIEW_EYE = sub_vec3(
             VIEW_EYE,
             mul_vec3_f32(NORM_CROSS(VIEW_TARGET, VIEW_UP), KEY_SENSITIVITY));
     }
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+    if (KEYS_HELD & KEY_RIGHT) {
         VIEW_EYE = add_vec3(
             VIEW_EYE,
             mul_vec3_f32(NORM_CROSS(VIEW_TARGET, VIEW_UP), KEY_SENSITIVITY));
     }
 }
 
-#define CURSOR_CALLBACK(x, y)                                            \
-    {                                                                    \
-        CURSOR_X = (f32)x;                                               \
-        CURSOR_Y = (f32)y;                                               \
-        VIEW_YAW += CURSOR_X_DELTA;                                      \
-        VIEW_PITCH += CURSOR_Y_DELTA;                                    \
-        if (PITCH_LIMIT < VIEW_PITCH) {                                  \
-            VIEW_PITCH = PITCH_LIMIT;                                    \
-        } else if (VIEW_PITCH < -PITCH_LIMIT) {                          \
-            VIEW_PITCH = -PITCH_LIMIT;                                   \
-        }                                                                \
-        VIEW_TARGET.x =                                                  \
-            cosf(get_radians(VIEW_YAW)) * cosf(get_radians(VIEW_PITCH)); \
-        VIEW_TARGET.y = sinf(get_radians(VIEW_PITCH));                   \
-        VIEW_TARGET.z =                                                  \
-            sinf(get_radians(VIEW_YAW)) * cosf(get_radians(VIEW_PITCH)); \
-        VIEW_TARGET = norm_vec3(VIEW_TARGET);                            \
-    }
-
-static void cursor_callback(GLFWwindow* _, f64 x, f64 y) {
-    CURSOR_X_DELTA = ((f32)x - CURSOR_X) * CURSOR_SENSITIVITY;
-    CURSOR_Y_DELTA = (CURSOR_Y - (f32)y) * CURSOR_SENSITIVITY;
-    CURSOR_CALLBACK(x, y);
-}
-
-static void init_cursor_callback(GLFWwindow* window, f64 x, f64 y) {
-    CURSOR_CALLBACK(x, y);
-    glfwSetCursorPosCallback(window, cursor_callback);
-}
-
-static void framebuffer_size_callback(GLFWwindow* window,
-                                      i32         width,
-                                      i32         height) {
-    WINDOW_WIDTH = width;
-    WINDOW_HEIGHT = height;
-}
-
 static GLFWwindow* get_window(const char* name) {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef DEBUG
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, TRUE);
+#endif
     GLFWwindow* window = glfwCreateWindow(INIT_WINDOW_WIDTH,
                                           INIT_WINDOW_HEIGHT,
                                           name,
@@ -297,7 +573,12 @@ static GLFWwindow* get_window(const char* name) {
         ERROR("!window");
     }
     glfwMakeContextCurrent(window);
+    INIT_DEBUG();
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetWindowRefreshCallback(window, refresh_callback);
+    glfwSetWindowIconifyCallback(window, iconify_callback);
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetCursorPosCallback(window, cursor_callback);
     glfwSetWindowAspectRatio(window, INIT_WINDOW_WIDTH, INIT_WINDOW_HEIGHT);
     // NOTE: While mouse *does* get locked to center of window, it remains
     // visible. See `https://github.com/glfw/glfw/issues/1790`.
@@ -365,31 +646,264 @@ static u32 get_program(Memory* memory,
     glDeleteShader(vertex_shader);
     glDeleteShader(fragment_shader);
     glUseProgram(program);
+    LABEL_DEBUG(GL_PROGRAM, program, "program");
     return program;
 }
 
-static void set_translations(void) {
-    u8 k = 0;
+static void set_scene(void) {
+    Vec3 zero = {0};
+    Vec3 one = {
+        .x = 1.0f,
+        .y = 1.0f,
+        .z = 1.0f,
+    };
+    SCENE_ROOT = push_node(&SCENE, NODE_NONE, zero, 0.0f, VIEW_UP, one);
+    u32 k = 0;
     for (u8 i = 0; i < COUNT_COORDS; ++i) {
-        if (COUNT_TRANSLATIONS < k) {
-            ERROR("COUNT_TRANSLATIONS < k");
-        }
+        Vec3 column = {
+            .x = COORDS[i],
+            .y = 0.0f,
+            .z = 0.0f,
+        };
+        SCENE_COLUMNS[i] =
+            push_node(&SCENE, SCENE_ROOT, column, 0.0f, VIEW_UP, one);
         for (u8 j = 0; j < COUNT_COORDS; ++j) {
             Vec3 position = {
-                .x = COORDS[i],
+                .x = 0.0f,
                 .y = -COORDS[j],
                 .z = 0.0f,
             };
-            f32  size = 2.0f / sqrtf((f32)k + 1.0f);
+            f32  t = (f32)(k++);
+            f32  size = 2.0f / sqrtf(t + 1.0f);
             Vec3 scale = {
                 .x = size,
                 .y = size,
                 .z = size,
             };
-            TRANSLATIONS[k++] =
-                mul_mat4(translate_mat4(position), scale_mat4(scale));
+            u32 node = push_node(&SCENE,
+                                 SCENE_COLUMNS[i],
+                                 position,
+                                 0.0f,
+                                 VIEW_UP,
+                                 scale);
+            push_instance(&SCENE, node);
+            Vec3 tilt = {
+                .x = sinf(t) * 0.25f,
+                .y = 0.0f,
+                .z = cosf(t) * 0.25f,
+            };
+            Animation animation = {
+                .axis = norm_vec3(add_vec3(ANIMATION_AXIS, tilt)),
+                .angular_velocity = get_radians(ANIMATION_DEGREES) *
+                                    (1.0f + (0.5f * sinf(t * 0.7f))),
+                .phase = t * 0.5f,
+                .amplitude = ANIMATION_AMPLITUDE,
+            };
+            ANIMATIONS[SCENE.instance[node]] = animation;
         }
     }
+    update_scene(&SCENE);
+}
+
+static void set_columns(f32 time) {
+    for (u8 i = 1; i < COUNT_COORDS; i += 2) {
+        Vec3 column = {
+            .x = COORDS[i],
+            .y = COLUMN_AMPLITUDE * sinf(time + (f32)i),
+            .z = 0.0f,
+        };
+        set_translation(&SCENE, SCENE_COLUMNS[i], column);
+    }
+}
+
+static void set_instances(void) {
+    u32 n = SCENE.len_instances;
+    for (u32 i = 0; i < n; ++i) {
+        u32 key = 0;
+        // NOTE: With sorting disabled every key is equal, so each radix pass
+        // is skipped and instances stay in scene order.
+        if (SORT_ENABLED) {
+            const f32* position = SCENE.instances[i].cell[3];
+            // NOTE: The camera looks down `-z`; positive depth is in front.
+            f32 depth = -((VIEW.cell[0][2] * position[0]) +
+                          (VIEW.cell[1][2] * position[1]) +
+                          (VIEW.cell[2][2] * position[2]) + VIEW.cell[3][2]);
+            f32 t = (depth - VIEW_NEAR) / (VIEW_FAR - VIEW_NEAR);
+            if (t < 0.0f) {
+                t = 0.0f;
+            } else if (1.0f < t) {
+                t = 1.0f;
+            }
+            key = (u32)(t * (f32)((1 << SORT_DEPTH_BITS) - 1));
+        }
+        SORT_KEYS[0][i] = key;
+        SORT_VALUES[0][i] = i;
+    }
+    SORT.keys = SORT_KEYS[0];
+    SORT.values = SORT_VALUES[0];
+    SORT.keys_swap = SORT_KEYS[1];
+    SORT.values_swap = SORT_VALUES[1];
+    SORT.len = n;
+    sort_radix(&SORT, &POOL);
+    if (!INSTANCES_DIRTY &&
+        !memcmp(SORT_ORDER, SORT.values, sizeof(u32) * n))
+    {
+        return;
+    }
+    INSTANCES_DIRTY = FALSE;
+    PUSH_DEBUG("instances");
+    memcpy(SORT_ORDER, SORT.values, sizeof(u32) * n);
+    for (u32 i = 0; i < n; ++i) {
+        SORTED_INSTANCES[i] = SCENE.instances[SORT_ORDER[i]];
+        SORTED_ANIMATIONS[i] = ANIMATIONS[SORT_ORDER[i]];
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, IBO);
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    0,
+                    (GLsizeiptr)(sizeof(Mat4) * n),
+                    SORTED_INSTANCES);
+    glBindBuffer(GL_ARRAY_BUFFER, ABO);
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    0,
+                    (GLsizeiptr)(sizeof(Animation) * n),
+                    SORTED_ANIMATIONS);
+    POP_DEBUG();
+}
+
+static void set_lights(void) {
+    u32 seed = 0x9E3779B9;
+    for (u32 i = 0; i < COUNT_LIGHTS; ++i) {
+        LIGHTS.x[i] = ((random_f32(&seed) * 2.0f) - 1.0f) * LIGHT_EXTENT.x;
+        LIGHTS.y[i] = ((random_f32(&seed) * 2.0f) - 1.0f) * LIGHT_EXTENT.y;
+        LIGHTS.z[i] = ((random_f32(&seed) * 2.0f) - 1.0f) * LIGHT_EXTENT.z;
+        LIGHTS.radius[i] =
+            LIGHT_RADIUS_MIN +
+            (random_f32(&seed) * (LIGHT_RADIUS_MAX - LIGHT_RADIUS_MIN));
+        LIGHTS.phase[i] = random_f32(&seed) * 2.0f * PI;
+        for (u32 j = 0; j < 3; ++j) {
+            LIGHTS.texels[i].color[j] = random_f32(&seed) * LIGHT_INTENSITY;
+        }
+    }
+    LIGHTS.len = COUNT_LIGHTS;
+    CLUSTERS.lights = &LIGHTS;
+    CLUSTERS.amplitude = LIGHT_AMPLITUDE;
+}
+
+static void set_light_buffers(State state) {
+    CLUSTERS.view = VIEW;
+    CLUSTERS.time = state.time;
+    set_cluster_projection(&CLUSTERS, PROJECTION, VIEW_NEAR, VIEW_FAR);
+    update_clusters(&CLUSTERS, &POOL);
+    PUSH_DEBUG("lights");
+    glBindBuffer(GL_TEXTURE_BUFFER, LBO);
+    glBufferSubData(GL_TEXTURE_BUFFER,
+                    0,
+                    (GLsizeiptr)(sizeof(LightTexel) * LIGHTS.len),
+                    LIGHTS.texels);
+    glBindBuffer(GL_TEXTURE_BUFFER, CBO);
+    glBufferSubData(GL_TEXTURE_BUFFER,
+                    0,
+                    sizeof(CLUSTERS.spans),
+                    CLUSTERS.spans);
+    glBindBuffer(GL_TEXTURE_BUFFER, XBO);
+    glBufferSubData(GL_TEXTURE_BUFFER,
+                    0,
+                    (GLsizeiptr)(sizeof(u32) * CLUSTERS.len_indices),
+                    CLUSTERS.indices);
+    POP_DEBUG();
+}
+
+static void set_particles(f32 dt) {
+    if (!PARTICLES_ENABLED || RENDER_PAUSED) {
+        return;
+    }
+    PUSH_DEBUG("particles");
+    glBindBuffer(GL_ARRAY_BUFFER, SBO);
+    // NOTE: Invalidating lets the driver hand back fresh storage instead of
+    // waiting for the GPU to finish reading last frame's.
+    PARTICLES.out =
+        glMapBufferRange(GL_ARRAY_BUFFER,
+                         0,
+                         sizeof(f32) * 4 * CAP_PARTICLES,
+                         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!PARTICLES.out) {
+        ERROR("`glMapBufferRange` failed");
+    }
+    update_particles(&PARTICLES,
+                     &POOL,
+                     dt < PARTICLE_DT_MAX ? dt : PARTICLE_DT_MAX);
+    // NOTE: If the store was lost (e.g. on a mode switch) this returns
+    // `FALSE`; the next frame rewrites the buffer in full anyway.
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    PARTICLES.out = NULL;
+    POP_DEBUG();
+}
+
+// NOTE: Hands evicted slots back, then copies ready chunks into free slots
+// until `WORLD_BUDGET` runs out; whatever is left waits for the next frame.
+static void set_world(void) {
+    WORLD_UPLOADED = 0;
+    if (!WORLD_ENABLED) {
+        return;
+    }
+    f64 start = glfwGetTime();
+    set_world_eye(&WORLD, VIEW_EYE);
+    u32 chunk;
+    while (pop_world_evict(&WORLD, &chunk)) {
+        u32 slot = WORLD.slots[chunk];
+        WORLD.slots[chunk] = WORLD_NONE;
+        WORLD_SLOT_CHUNKS[slot] = WORLD_NONE;
+        WORLD_FREE[WORLD_LEN_FREE++] = slot;
+        --WORLD_LEN_RESIDENT;
+        RENDER_DIRTY = TRUE;
+    }
+    PUSH_DEBUG("world");
+    glBindBuffer(GL_ARRAY_BUFFER, WBO);
+    while (((glfwGetTime() - start) < WORLD_BUDGET) &&
+           pop_world_ready(&WORLD, &chunk))
+    {
+        u32               slot = WORLD_FREE[--WORLD_LEN_FREE];
+        const WorldChunk* world_chunk = &WORLD.chunks[chunk];
+        usize size = SIZE_WORLD_INSTANCE * world_chunk->len_instances;
+        glBufferSubData(GL_ARRAY_BUFFER,
+                        (GLintptr)(SIZE_WORLD_SLOT * slot),
+                        (GLsizeiptr)size,
+                        WORLD.map + world_chunk->offset);
+        WORLD.slots[chunk] = slot;
+        WORLD_SLOT_CHUNKS[slot] = chunk;
+        ++WORLD_LEN_RESIDENT;
+        WORLD_UPLOADED += size;
+        RENDER_DIRTY = TRUE;
+    }
+    POP_DEBUG();
+    if (get_world_ready(&WORLD) != 0) {
+        RENDER_DIRTY = TRUE;
+    }
+    // NOTE: Nearest first.
+    WORLD_LEN_DRAWS = 0;
+    for (u32 slot = 0; slot < CAP_WORLD_SLOTS; ++slot) {
+        chunk = WORLD_SLOT_CHUNKS[slot];
+        if (chunk != WORLD_NONE) {
+            WORLD_DRAWS[WORLD_LEN_DRAWS++] = get_chunk_key(
+                get_chunk_distance(&WORLD.chunks[chunk], VIEW_EYE),
+                slot);
+        }
+    }
+    qsort(WORLD_DRAWS, WORLD_LEN_DRAWS, sizeof(WORLD_DRAWS[0]), compare_u64);
+}
+
+static void set_texture_buffer(u32*   buffer,
+                               u32*   texture,
+                               u32    unit,
+                               GLenum format,
+                               usize  size) {
+    glGenBuffers(1, buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, *buffer);
+    glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)size, NULL, GL_STREAM_DRAW);
+    glGenTextures(1, texture);
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_BUFFER, *texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, *buffer);
 }
 
 static void set_vertex_attrib(u32 index, i32 size, i32 stride, void* offset) {
@@ -397,10 +911,35 @@ static void set_vertex_attrib(u32 index, i32 size, i32 stride, void* offset) {
     glVertexAttribPointer(index, size, GL_FLOAT, GL_FALSE, stride, offset);
 }
 
+// NOTE: Binds the cube mesh into the current vertex array; shared by every
+// instanced draw.
+static void set_mesh(void) {
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    i32 position_width = 3;
+    i32 color_width = 3;
+    i32 stride = ((i32)(sizeof(f32))) * (position_width + color_width);
+    set_vertex_attrib(INDEX_POSITION,
+                      position_width,
+                      stride,
+                      (void*)POSITION_OFFSET);
+    set_vertex_attrib(INDEX_COLOR,
+                      color_width,
+                      stride,
+                      (void*)(sizeof(f32) * (usize)position_width));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+}
+
+// NOTE: Applies to the cube's per-instance attributes in the current vertex
+// array.
+static void set_divisors(u32 divisor) {
+    for (u32 i = 0; i < 4; ++i) {
+        glVertexAttribDivisor(INDEX_TRANSLATE + i, divisor);
+    }
+    glVertexAttribDivisor(INDEX_SPIN, divisor);
+    glVertexAttribDivisor(INDEX_WAVE, divisor);
+}
+
 static void set_objects(void) {
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
-    CHECK_GL_ERROR();
     {
         glGenBuffers(1, &VBO);
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
@@ -408,20 +947,6 @@ static void set_objects(void) {
                      sizeof(POSITIONS_COLORS),
                      POSITIONS_COLORS,
                      GL_STATIC_DRAW);
-        i32 position_width = 3;
-        i32 color_width = 3;
-        i32 stride = ((i32)(sizeof(f32))) * (position_width + color_width);
-        set_vertex_attrib(INDEX_POSITION,
-                          position_width,
-                          stride,
-                          (void*)POSITION_OFFSET);
-        set_vertex_attrib(INDEX_COLOR,
-                          color_width,
-                          stride,
-                          (void*)(sizeof(f32) * (usize)position_width));
-        CHECK_GL_ERROR();
-    }
-    {
         glGenBuffers(1, &EBO);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER,
@@ -430,15 +955,19 @@ static void set_objects(void) {
                      GL_STATIC_DRAW);
         CHECK_GL_ERROR();
     }
+    glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+    set_mesh();
+    CHECK_GL_ERROR();
     {
-        set_translations();
+        set_scene();
         glGenBuffers(1, &IBO);
         glBindBuffer(GL_ARRAY_BUFFER, IBO);
         glBufferData(GL_ARRAY_BUFFER,
-                     sizeof(TRANSLATIONS),
-                     &TRANSLATIONS[0].cell[0][0],
-                     GL_STATIC_DRAW);
-        i32 stride = sizeof(TRANSLATIONS[0]);
+                     (GLsizeiptr)(sizeof(Mat4) * SCENE.len_instances),
+                     &SCENE.instances[0].cell[0][0],
+                     GL_DYNAMIC_DRAW);
+        i32 stride = sizeof(Mat4);
         // NOTE: Instances are limited to `sizeof(f32) * 4`, so `Mat4` data
         // must be constructed in four parts.
         usize offset = sizeof(f32) * 4;
@@ -449,6 +978,87 @@ static void set_objects(void) {
         }
         CHECK_GL_ERROR();
     }
+    {
+        glGenBuffers(1, &ABO);
+        glBindBuffer(GL_ARRAY_BUFFER, ABO);
+        glBufferData(GL_ARRAY_BUFFER,
+                     (GLsizeiptr)(sizeof(Animation) * SCENE.len_instances),
+                     ANIMATIONS,
+                     GL_DYNAMIC_DRAW);
+        i32 stride = sizeof(Animation);
+        // NOTE: `(axis, angular_velocity)` and `(phase, amplitude)`.
+        set_vertex_attrib(INDEX_SPIN, 4, stride, (void*)0);
+        set_vertex_attrib(INDEX_WAVE, 2, stride, (void*)(sizeof(f32) * 4));
+        glVertexAttribDivisor(INDEX_SPIN, 1);
+        glVertexAttribDivisor(INDEX_WAVE, 1);
+        CHECK_GL_ERROR();
+    }
+    {
+        init_particles(&PARTICLES, PARTICLE_ARRAYS, PARTICLE_EMITTER);
+        glGenVertexArrays(1, &PAO);
+        glBindVertexArray(PAO);
+        set_mesh();
+        glGenBuffers(1, &SBO);
+        glBindBuffer(GL_ARRAY_BUFFER, SBO);
+        glBufferData(GL_ARRAY_BUFFER,
+                     sizeof(f32) * 4 * CAP_PARTICLES,
+                     NULL,
+                     GL_STREAM_DRAW);
+        for (u32 i = 0; i < 4; ++i) {
+            u32 index = INDEX_PARTICLE + i;
+            set_vertex_attrib(index,
+                              1,
+                              0,
+                              (void*)(sizeof(f32) * CAP_PARTICLES * i));
+            glVertexAttribDivisor(index, 1);
+        }
+        glBindVertexArray(VAO);
+        CHECK_GL_ERROR();
+    }
+    if (WORLD_ENABLED) {
+        glGenVertexArrays(1, &WAO);
+        glBindVertexArray(WAO);
+        set_mesh();
+        glGenBuffers(1, &WBO);
+        glBindBuffer(GL_ARRAY_BUFFER, WBO);
+        glBufferData(GL_ARRAY_BUFFER,
+                     SIZE_WORLD_SLOT * CAP_WORLD_SLOTS,
+                     NULL,
+                     GL_STATIC_DRAW);
+        set_divisors(1);
+        for (u32 i = 0; i < CAP_WORLD_SLOTS; ++i) {
+            WORLD_SLOT_CHUNKS[i] = WORLD_NONE;
+            WORLD_FREE[WORLD_LEN_FREE++] = (CAP_WORLD_SLOTS - 1) - i;
+        }
+        glBindVertexArray(VAO);
+        LABEL_DEBUG(GL_VERTEX_ARRAY, WAO, "WAO");
+        LABEL_DEBUG(GL_BUFFER, WBO, "WBO");
+        CHECK_GL_ERROR();
+    }
+    {
+        set_lights();
+        i32 max_texels;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+        CLUSTERS.cap_indices = (u32)max_texels < CAP_LIGHT_INDICES
+                                   ? (u32)max_texels
+                                   : CAP_LIGHT_INDICES;
+        set_texture_buffer(&LBO,
+                           &LTO,
+                           UNIT_LIGHTS,
+                           GL_RGBA32F,
+                           sizeof(LightTexel) * CAP_LIGHTS);
+        set_texture_buffer(&CBO,
+                           &CTO,
+                           UNIT_CLUSTERS,
+                           GL_RG32UI,
+                           sizeof(CLUSTERS.spans));
+        set_texture_buffer(&XBO,
+                           &XTO,
+                           UNIT_LIGHT_INDICES,
+                           GL_R32UI,
+                           sizeof(u32) * CLUSTERS.cap_indices);
+        CHECK_GL_ERROR();
+    }
     {
         glGenRenderbuffers(1, &RBO);
         glBindRenderbuffer(GL_RENDERBUFFER, RBO);
@@ -478,10 +1088,40 @@ static void set_objects(void) {
         CHECK_GL_ERROR();
     }
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-        CHECK_GL_ERROR();
+        ERROR("glCheckFramebufferStatus(GL_FRAMEBUFFER) != "
+              "GL_FRAMEBUFFER_COMPLETE");
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glEnable(GL_DEPTH_TEST);
+    // NOTE: Written by the vertex shaders to clip each view to its tile.
+    glEnable(GL_CLIP_DISTANCE0);
+    glEnable(GL_CLIP_DISTANCE1);
+    glGenQueries(COUNT_QUERIES, QUERIES);
+    glGenQueries(COUNT_QUERIES, TIMERS);
+    glGenQueries(COUNT_QUERIES, COUNTERS);
+    GPU_BYTES = sizeof(POSITIONS_COLORS) + sizeof(INDICES) +
+                ((sizeof(Mat4) + sizeof(Animation)) * SCENE.len_instances) +
+                (sizeof(f32) * 4 * CAP_PARTICLES) +
+                (WORLD_ENABLED ? SIZE_WORLD_SLOT * CAP_WORLD_SLOTS : 0) +
+                (sizeof(LightTexel) * CAP_LIGHTS) + sizeof(CLUSTERS.spans) +
+                (sizeof(u32) * CLUSTERS.cap_indices) +
+                ((3 + 4) * (u64)(FBO_WIDTH * FBO_HEIGHT));
+    LABEL_DEBUG(GL_VERTEX_ARRAY, VAO, "VAO");
+    LABEL_DEBUG(GL_VERTEX_ARRAY, PAO, "PAO");
+    LABEL_DEBUG(GL_BUFFER, VBO, "VBO");
+    LABEL_DEBUG(GL_BUFFER, EBO, "EBO");
+    LABEL_DEBUG(GL_BUFFER, IBO, "IBO");
+    LABEL_DEBUG(GL_BUFFER, ABO, "ABO");
+    LABEL_DEBUG(GL_BUFFER, SBO, "SBO");
+    LABEL_DEBUG(GL_BUFFER, LBO, "LBO");
+    LABEL_DEBUG(GL_BUFFER, CBO, "CBO");
+    LABEL_DEBUG(GL_BUFFER, XBO, "XBO");
+    LABEL_DEBUG(GL_TEXTURE, LTO, "LTO");
+    LABEL_DEBUG(GL_TEXTURE, CTO, "CTO");
+    LABEL_DEBUG(GL_TEXTURE, XTO, "XTO");
+    LABEL_DEBUG(GL_FRAMEBUFFER, FBO, "FBO");
+    LABEL_DEBUG(GL_RENDERBUFFER, RBO, "RBO");
+    LABEL_DEBUG(GL_RENDERBUFFER, DBO, "DBO");
     CHECK_GL_ERROR();
 }
 
@@ -491,7 +1131,16 @@ static Uniforms get_uniforms(u32 program) {
         .time = glGetUniformLocation(program, "U_TIME"),
         .projection = glGetUniformLocation(program, "U_PROJECTION"),
         .view = glGetUniformLocation(program, "U_VIEW"),
-        .transform = glGetUniformLocation(program, "U_TRANSFORM"),
+        .lights = glGetUniformLocation(program, "U_LIGHTS"),
+        .clusters = glGetUniformLocation(program, "U_CLUSTERS"),
+        .light_indices = glGetUniformLocation(program, "U_LIGHT_INDICES"),
+        .cluster_size = glGetUniformLocation(program, "U_CLUSTER_SIZE"),
+        .cluster_depth = glGetUniformLocation(program, "U_CLUSTER_DEPTH"),
+        .view_projections =
+            glGetUniformLocation(program, "U_VIEW_PROJECTIONS"),
+        .view_first = glGetUniformLocation(program, "U_VIEW_FIRST"),
+        .view_count = glGetUniformLocation(program, "U_VIEW_COUNT"),
+        .view_tiles = glGetUniformLocation(program, "U_VIEW_TILES"),
     };
     return uniforms;
 }
@@ -500,43 +1149,178 @@ static void set_static_uniforms(Uniforms uniforms) {
     MODEL = mul_mat4(rotate_mat4(get_radians(MODEL_DEGREES), MODEL_AXIS),
                      scale_mat4(MODEL_SCALE));
     glUniformMatrix4fv(uniforms.model, 1, FALSE, &MODEL.cell[0][0]);
+    glUniform1i(uniforms.lights, (i32)UNIT_LIGHTS);
+    glUniform1i(uniforms.clusters, (i32)UNIT_CLUSTERS);
+    glUniform1i(uniforms.light_indices, (i32)UNIT_LIGHT_INDICES);
+    glUniform3i(uniforms.cluster_size, CLUSTER_X, CLUSTER_Y, CLUSTER_Z);
     CHECK_GL_ERROR();
 }
 
+static void set_view(void) {
+    PROJECTION = perspective_mat4(
+        get_radians(45.0f),
+        (f32)WINDOW_WIDTH / (f32)(WINDOW_HEIGHT * (i32)VIEW_COUNT),
+        VIEW_NEAR,
+        VIEW_FAR);
+    VIEW = look_at_mat4(VIEW_EYE, add_vec3(VIEW_EYE, VIEW_TARGET), VIEW_UP);
+    Vec3 right = NORM_CROSS(VIEW_TARGET, VIEW_UP);
+    f32  center = (f32)(VIEW_COUNT - 1) / 2.0f;
+    for (u32 i = 0; i < VIEW_COUNT; ++i) {
+        Vec3 eye = add_vec3(
+            VIEW_EYE,
+            mul_vec3_f32(right, ((f32)i - center) * VIEW_SEPARATION));
+        VIEW_PROJECTIONS[i] =
+            mul_mat4(PROJECTION,
+                     look_at_mat4(eye, add_vec3(eye, VIEW_TARGET), VIEW_UP));
+    }
+}
+
+// NOTE: In a single pass each instance is drawn once per view, back to back,
+// so per-instance attributes must advance that much slower.
+static void set_view_divisor(void) {
+    u32 divisor = VIEW_SINGLE_PASS ? VIEW_COUNT : 1;
+    if (divisor == VIEW_DIVISOR) {
+        return;
+    }
+    VIEW_DIVISOR = divisor;
+    glBindVertexArray(PAO);
+    for (u32 i = 0; i < 4; ++i) {
+        glVertexAttribDivisor(INDEX_PARTICLE + i, divisor);
+    }
+    if (WORLD_ENABLED) {
+        glBindVertexArray(WAO);
+        set_divisors(divisor);
+    }
+    glBindVertexArray(VAO);
+    set_divisors(divisor);
+}
+
 static void set_dynamic_uniforms(Uniforms uniforms, State state) {
     glUniform1f(uniforms.time, state.time);
-    PROJECTION = perspective_mat4(get_radians(45.0f),
-                                  (f32)WINDOW_WIDTH / (f32)WINDOW_HEIGHT,
-                                  VIEW_NEAR,
-                                  VIEW_FAR);
     glUniformMatrix4fv(uniforms.projection, 1, FALSE, &PROJECTION.cell[0][0]);
-    VIEW = look_at_mat4(VIEW_EYE, add_vec3(VIEW_EYE, VIEW_TARGET), VIEW_UP);
     glUniformMatrix4fv(uniforms.view, 1, FALSE, &VIEW.cell[0][0]);
-    TRANSFORM =
-        rotate_mat4(get_radians((f32)state.time * 25.0f), TRANSFORM_AXIS);
-    glUniformMatrix4fv(uniforms.transform, 1, FALSE, &TRANSFORM.cell[0][0]);
-    CHECK_GL_ERROR();
+    glUniform2f(uniforms.cluster_depth,
+                CLUSTERS.depth_scale,
+                CLUSTERS.depth_bias);
+    glUniformMatrix4fv(uniforms.view_projections,
+                       (i32)VIEW_COUNT,
+                       FALSE,
+                       &VIEW_PROJECTIONS[0].cell[0][0]);
+    glUniform1i(uniforms.view_first, 0);
+    glUniform1i(uniforms.view_count, (i32)VIEW_DIVISOR);
+    glUniform1i(uniforms.view_tiles, (i32)VIEW_COUNT);
+}
+
+static void get_query(u32 query, u32* result) {
+    i32 available;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available) {
+        glGetQueryObjectuiv(query, GL_QUERY_RESULT, result);
+    }
+}
+
+static void draw_instances(u32 vao, u32 count) {
+    ++DRAW_CALLS;
+    glBindVertexArray(vao);
+    glDrawElementsInstanced(GL_TRIANGLES,
+                            sizeof(INDICES) / sizeof(INDICES[0]),
+                            GL_UNSIGNED_INT,
+                            (void*)POSITION_OFFSET,
+                            (i32)count);
 }
 
-static void draw(GLFWwindow* window) {
+// NOTE: GL 3.3 has no base instance, so each chunk re-points the
+// per-instance attributes at its own slot.
+static void set_world_attribs(u32 slot, u32 len) {
+    usize base = SIZE_WORLD_SLOT * slot;
+    i32   stride = sizeof(Mat4);
+    usize offset = sizeof(f32) * 4;
+    for (u32 i = 0; i < 4; ++i) {
+        set_vertex_attrib(INDEX_TRANSLATE + i,
+                          4,
+                          stride,
+                          (void*)(base + (i * offset)));
+    }
+    usize animations = base + (sizeof(Mat4) * len);
+    stride = sizeof(Animation);
+    set_vertex_attrib(INDEX_SPIN, 4, stride, (void*)animations);
+    set_vertex_attrib(INDEX_WAVE, 2, stride, (void*)(animations + offset));
+}
+
+// NOTE: One draw per resident chunk, in the order `set_world` left them.
+static void draw_world(u32 views) {
+    glBindVertexArray(WAO);
+    glBindBuffer(GL_ARRAY_BUFFER, WBO);
+    for (u32 i = 0; i < WORLD_LEN_DRAWS; ++i) {
+        u32 slot = (u32)WORLD_DRAWS[i];
+        u32 len = WORLD.chunks[WORLD_SLOT_CHUNKS[slot]].len_instances;
+        set_world_attribs(slot, len);
+        draw_instances(WAO, len * views);
+    }
+}
+
+// NOTE: Every instance is drawn `views` times in a row (see
+// `set_view_divisor`).
+static void draw_scene(u32 program, u32 particle_program, u32 views) {
+    draw_instances(VAO, SCENE.len_instances * views);
+    if (WORLD_ENABLED) {
+        draw_world(views);
+    }
+    if (PARTICLES_ENABLED && (PARTICLES.len != 0)) {
+        glUseProgram(particle_program);
+        draw_instances(PAO, PARTICLES.len * views);
+        glUseProgram(program);
+    }
+}
+
+static void draw(u32      program,
+                 Uniforms uniforms,
+                 u32      particle_program,
+                 Uniforms particle_uniforms) {
+    DRAW_CALLS = 0;
     {
         // NOTE: Bind off-screen render target.
+        PUSH_DEBUG("clear");
         glBindFramebuffer(GL_FRAMEBUFFER, FBO);
         glDrawBuffer(GL_COLOR_ATTACHMENT0);
         glViewport(0, 0, FBO_WIDTH, FBO_HEIGHT);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        POP_DEBUG();
     }
     {
         // NOTE: Draw scene.
-        glBindVertexArray(VAO);
-        glDrawElementsInstanced(GL_TRIANGLES,
-                                sizeof(INDICES) / sizeof(INDICES[0]),
-                                GL_UNSIGNED_INT,
-                                (void*)POSITION_OFFSET,
-                                COUNT_TRANSLATIONS);
+        PUSH_DEBUG("scene");
+        u32 query = QUERIES[QUERY_INDEX % COUNT_QUERIES];
+        u32 timer = TIMERS[QUERY_INDEX % COUNT_QUERIES];
+        u32 counter = COUNTERS[QUERY_INDEX % COUNT_QUERIES];
+        if (COUNT_QUERIES <= QUERY_INDEX) {
+            get_query(query, &SAMPLES);
+            get_query(timer, &GPU_NANOSECONDS);
+            get_query(counter, &PRIMITIVES);
+        }
+        glBeginQuery(GL_SAMPLES_PASSED, query);
+        glBeginQuery(GL_TIME_ELAPSED, timer);
+        glBeginQuery(GL_PRIMITIVES_GENERATED, counter);
+        if (VIEW_SINGLE_PASS) {
+            draw_scene(program, particle_program, VIEW_COUNT);
+        } else {
+            for (u32 i = 0; i < VIEW_COUNT; ++i) {
+                glUseProgram(particle_program);
+                glUniform1i(particle_uniforms.view_first, (i32)i);
+                glUseProgram(program);
+                glUniform1i(uniforms.view_first, (i32)i);
+                draw_scene(program, particle_program, 1);
+            }
+        }
+        glEndQuery(GL_PRIMITIVES_GENERATED);
+        glEndQuery(GL_TIME_ELAPSED);
+        glEndQuery(GL_SAMPLES_PASSED);
+        ++QUERY_INDEX;
+        POP_DEBUG();
     }
     {
         // NOTE: Blit off-screen to on-screen.
+        PUSH_DEBUG("blit");
         glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
         glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
         glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
@@ -550,59 +1334,176 @@ static void draw(GLFWwindow* window) {
                           WINDOW_HEIGHT,
                           GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT,
                           GL_NEAREST);
+        POP_DEBUG();
     }
-    glfwSwapBuffers(window);
-}
-
-static void set_frame(Frame* frame) {
-    f32 now = (f32)glfwGetTime() * MICROSECONDS;
-    f32 elapsed = (now - frame->time);
-    if (elapsed < FRAME_DURATION) {
-        usleep((u32)(FRAME_DURATION - elapsed));
-    }
-    if (++frame->fps_count == 30) {
-        printf("\033[4A"
-               "fps    :%8.2f\n"
-               "eye    :%8.2f%8.2f%8.2f\n"
-               "target :%8.2f%8.2f%8.2f\n"
-               "up     :%8.2f%8.2f%8.2f\n",
-               (frame->fps_count / (now - frame->fps_time)) * MICROSECONDS,
-               VIEW_EYE.x,
-               VIEW_EYE.y,
-               VIEW_EYE.z,
-               VIEW_TARGET.x,
-               VIEW_TARGET.y,
-               VIEW_TARGET.z,
-               VIEW_UP.x,
-               VIEW_UP.y,
-               VIEW_UP.z);
-        frame->fps_time = frame->time;
-        frame->fps_count = 0;
+}
+
+static Bool get_render(void) {
+    return !WINDOW_ICONIFIED && (!RENDER_ON_DEMAND || RENDER_DIRTY ||
+                                 !RENDER_PAUSED || (KEYS_HELD != 0));
+}
+
+static void set_events(Frame* frame, Bool idle) {
+    if (idle) {
+        // NOTE: Nothing is moving; sleep until the OS hands us an event.
+        glfwWaitEventsTimeout(IDLE_TIMEOUT);
     }
+    // NOTE: Pace to `FRAME_DURATION`, but keep draining events while waiting
+    // so input latency is not tied to the frame rate.
+    for (;;) {
+        f32 elapsed = (f32)((glfwGetTime() * MICROSECONDS) - frame->prev);
+        if (FRAME_DURATION <= elapsed) {
+            glfwPollEvents();
+            return;
+        }
+        glfwWaitEventsTimeout(
+            (f64)((FRAME_DURATION - elapsed) / MICROSECONDS));
+    }
+}
+
+static f64 set_pass(Pass pass, f64 start) {
+    f64 now = glfwGetTime();
+    RECORD.passes[pass] = (f32)((now - start) * MICROSECONDS);
+    return now;
+}
+
+static void set_frame(Frame* frame, Bool rendered) {
     frame->prev = frame->time;
+    if (!rendered) {
+        return;
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    RECORD.frame = frame->count++;
+    RECORD.time = frame->time / MICROSECONDS;
+    RECORD.frame_time = (f32)(frame->time - frame->rendered);
+    RECORD.passes[PASS_GPU] = (f32)GPU_NANOSECONDS / 1000.0f;
+    RECORD.eye[0] = VIEW_EYE.x;
+    RECORD.eye[1] = VIEW_EYE.y;
+    RECORD.eye[2] = VIEW_EYE.z;
+    RECORD.target[0] = VIEW_TARGET.x;
+    RECORD.target[1] = VIEW_TARGET.y;
+    RECORD.target[2] = VIEW_TARGET.z;
+    RECORD.instances = SCENE.len_instances;
+    RECORD.particles = PARTICLES_ENABLED ? PARTICLES.len : 0;
+    RECORD.world_chunks = WORLD_LEN_RESIDENT;
+    RECORD.world_queued = WORLD_ENABLED ? get_world_ready(&WORLD) : 0;
+    RECORD.world_bytes = WORLD_UPLOADED;
+    RECORD.lights = LIGHTS.len;
+    RECORD.light_indices = CLUSTERS.len_indices;
+    RECORD.light_overflow = CLUSTERS.overflow;
+    RECORD.samples = SAMPLES;
+    RECORD.pixels = (u32)(FBO_WIDTH * FBO_HEIGHT);
+    RECORD.sorted = (u32)SORT_ENABLED;
+    RECORD.views = VIEW_COUNT;
+    RECORD.single_pass = (u32)VIEW_SINGLE_PASS;
+    RECORD.draw_calls = DRAW_CALLS;
+    RECORD.primitives = PRIMITIVES;
+    RECORD.gpu_bytes = GPU_BYTES;
+    RECORD.max_rss_bytes = (u64)usage.ru_maxrss * 1024;
+    push_telemetry(TELEMETRY, &RECORD);
+    frame->rendered = frame->time;
 }
 
-static void loop(GLFWwindow* window, u32 program) {
+static void loop(GLFWwindow* window, u32 program, u32 particle_program) {
     State    state = {0};
     Frame    frame = {0};
     Uniforms uniforms = get_uniforms(program);
+    Uniforms particle_uniforms = get_uniforms(particle_program);
+    glUseProgram(particle_program);
+    set_static_uniforms(particle_uniforms);
+    glUseProgram(program);
     set_static_uniforms(uniforms);
     glClearColor(0.15f, 0.15f, 0.15f, 1.0f);
-    printf("\n\n\n\n");
     while (!glfwWindowShouldClose(window)) {
-        state.time = (f32)glfwGetTime();
-        frame.time = state.time * MICROSECONDS;
-        frame.delta += frame.time - frame.prev;
+        set_events(&frame, !get_render());
+        f64 start = glfwGetTime();
+        frame.time = start * MICROSECONDS;
+        f32 elapsed = (f32)(frame.time - frame.prev);
+        if (!RENDER_PAUSED) {
+            state.time += elapsed / MICROSECONDS;
+        }
+        set_input(window);
+        // NOTE: Clamp so a long idle wait does not turn into a burst of
+        // movement steps once a key goes down.
+        frame.delta += elapsed;
+        if (FRAME_DURATION < frame.delta) {
+            frame.delta = FRAME_DURATION;
+        }
         while (FRAME_UPDATE_STEP < frame.delta) {
-            set_input(window);
+            set_movement();
             frame.delta -= FRAME_UPDATE_STEP;
         }
-        set_dynamic_uniforms(uniforms, state);
-        draw(window);
-        set_frame(&frame);
+        start = set_pass(PASS_INPUT, start);
+        // NOTE: Paused time means nothing moved; leave the scene clean.
+        if (!RENDER_PAUSED) {
+            set_columns(state.time);
+        }
+        update_scene(&SCENE);
+        if (SCENE.instance_first < SCENE.instance_last) {
+            INSTANCES_DIRTY = TRUE;
+            RENDER_DIRTY = TRUE;
+        }
+        start = set_pass(PASS_SCENE, start);
+        set_world();
+        start = set_pass(PASS_WORLD, start);
+        Bool render = get_render();
+        if (render) {
+            set_view();
+            set_view_divisor();
+            set_instances();
+            start = set_pass(PASS_INSTANCES, start);
+            set_light_buffers(state);
+            start = set_pass(PASS_LIGHTS, start);
+            set_particles(elapsed / MICROSECONDS);
+            start = set_pass(PASS_PARTICLES, start);
+            glUseProgram(particle_program);
+            set_dynamic_uniforms(particle_uniforms, state);
+            glUseProgram(program);
+            set_dynamic_uniforms(uniforms, state);
+            draw(program, uniforms, particle_program, particle_uniforms);
+            start = set_pass(PASS_SUBMIT, start);
+            glfwSwapBuffers(window);
+            set_pass(PASS_SWAP, start);
+            FLUSH_DEBUG();
+            RENDER_DIRTY = FALSE;
+        }
+        set_frame(&frame, render);
     }
 }
 
+static void init_telemetry(void) {
+    i32 file = shm_open(TELEMETRY_NAME, O_CREAT | O_RDWR, 0644);
+    if (file < 0) {
+        ERROR("`shm_open` failed");
+    }
+    if (ftruncate(file, sizeof(Telemetry))) {
+        ERROR("`ftruncate` failed");
+    }
+    TELEMETRY = mmap(NULL,
+                     sizeof(Telemetry),
+                     PROT_READ | PROT_WRITE,
+                     MAP_SHARED,
+                     file,
+                     0);
+    close(file);
+    if (TELEMETRY == MAP_FAILED) {
+        ERROR("`mmap` failed");
+    }
+    memset(TELEMETRY, 0, sizeof(Telemetry));
+    TELEMETRY->version = TELEMETRY_VERSION;
+    TELEMETRY->capacity = CAP_TELEMETRY;
+    TELEMETRY->size_record = sizeof(TelemetryRecord);
+    // NOTE: Written last so a reader never trusts a half-initialized header.
+    atomic_thread_fence(memory_order_release);
+    TELEMETRY->magic = TELEMETRY_MAGIC;
+}
+
+static void free_telemetry(void) {
+    munmap(TELEMETRY, sizeof(Telemetry));
+    shm_unlink(TELEMETRY_NAME);
+}
+
 static void error_callback(i32 code, const char* error) {
     fprintf(stderr, "%d: %s\n", code, error);
     exit(EXIT_FAILURE);
@@ -620,6 +1521,16 @@ i32 main(i32 n, const char** args) {
            "sizeof(Frame)          : %zu\n"
            "sizeof(Uniforms)       : %zu\n"
            "sizeof(State)          : %zu\n"
+           "sizeof(Events)         : %zu\n"
+           "sizeof(Scene)          : %zu\n"
+           "sizeof(Animation)      : %zu\n"
+           "sizeof(Lights)         : %zu\n"
+           "sizeof(Clusters)       : %zu\n"
+           "sizeof(Particles)      : %zu\n"
+           "sizeof(ParticleArrays) : %zu\n"
+           "sizeof(Telemetry)      : %zu\n"
+           "sizeof(World)          : %zu\n"
+           "sizeof(WorldChunk)     : %zu\n"
            "sizeof(Memory)         : %zu\n"
            "sizeof(memory->buffer) : %zu\n\n",
            sizeof(Bool),
@@ -628,11 +1539,25 @@ i32 main(i32 n, const char** args) {
            sizeof(Frame),
            sizeof(Uniforms),
            sizeof(State),
+           sizeof(Events),
+           sizeof(Scene),
+           sizeof(Animation),
+           sizeof(Lights),
+           sizeof(Clusters),
+           sizeof(Particles),
+           sizeof(ParticleArrays),
+           sizeof(Telemetry),
+           sizeof(World),
+           sizeof(WorldChunk),
            sizeof(Memory),
            sizeof(memory->buffer));
-    if (n < 3) {
+    if (n < 4) {
         ERROR("Missing args");
     }
+    if (4 < n) {
+        open_world(&WORLD, args[4]);
+        WORLD_ENABLED = TRUE;
+    }
     glfwSetErrorCallback(error_callback);
     if (!glfwInit()) {
         ERROR("!glfwInit()");
@@ -641,24 +1566,56 @@ i32 main(i32 n, const char** args) {
     u32         program = get_program(memory,
                               get_shader(memory, args[1], GL_VERTEX_SHADER),
                               get_shader(memory, args[2], GL_FRAGMENT_SHADER));
+    // NOTE: Particles reuse the fragment shader; only vertex input differs.
+    u32 particle_program =
+        get_program(memory,
+                    get_shader(memory, args[3], GL_VERTEX_SHADER),
+                    get_shader(memory, args[2], GL_FRAGMENT_SHADER));
     set_objects();
+    init_pool(&POOL);
+    init_telemetry();
+    if (WORLD_ENABLED) {
+        init_world(&WORLD, VIEW_EYE, glfwPostEmptyEvent);
+    }
     Native native = {
         .display = glfwGetX11Display(),
         .window = glfwGetX11Window(window),
     };
     hide_cursor(native);
-    glfwSetCursorPosCallback(window, init_cursor_callback);
-    loop(window, program);
+    loop(window, program, particle_program);
     show_cursor(native);
+    // NOTE: The streaming thread may call `glfwPostEmptyEvent`; it has to be
+    // gone before `glfwTerminate`.
+    if (WORLD_ENABLED) {
+        free_world(&WORLD);
+    }
     glDeleteVertexArrays(1, &VAO);
+    glDeleteVertexArrays(1, &PAO);
+    glDeleteVertexArrays(1, &WAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
     glDeleteBuffers(1, &IBO);
+    glDeleteBuffers(1, &ABO);
+    glDeleteBuffers(1, &SBO);
+    glDeleteBuffers(1, &WBO);
+    glDeleteBuffers(1, &LBO);
+    glDeleteBuffers(1, &CBO);
+    glDeleteBuffers(1, &XBO);
+    glDeleteTextures(1, &LTO);
+    glDeleteTextures(1, &CTO);
+    glDeleteTextures(1, &XTO);
     glDeleteFramebuffers(1, &FBO);
     glDeleteRenderbuffers(1, &RBO);
     glDeleteRenderbuffers(1, &DBO);
+    glDeleteQueries(COUNT_QUERIES, QUERIES);
+    glDeleteQueries(COUNT_QUERIES, TIMERS);
+    glDeleteQueries(COUNT_QUERIES, COUNTERS);
     glDeleteProgram(program);
+    glDeleteProgram(particle_program);
+    FLUSH_DEBUG();
     glfwTerminate();
+    free_pool(&POOL);
+    free_telemetry();
     free(memory);
     return EXIT_SUCCESS;
 }
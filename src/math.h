@@ -39,6 +39,17 @@ static f32 get_degrees(f32 radians) {
     return (radians * 180.0f) / PI;
 }
 
+// NOTE: xorshift32; `state` must start non-zero. Returns a value in
+// `[0.0f, 1.0f)`.
+static f32 random_f32(u32* state) {
+    u32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return (f32)(x >> 8) / (f32)(1 << 24);
+}
+
 static Vec3 add_vec3(Vec3 l, Vec3 r) {
     Vec3 out = {
         .x = l.x + r.x,
@@ -160,6 +171,18 @@ static Mat4 rotate_mat4(f32 radians, Vec3 axis) {
     return out;
 }
 
+// NOTE: Equivalent to `translate_mat4(t) * rotate_mat4(r, axis) *
+// scale_mat4(s)`, without the two full matrix products.
+static Mat4 trs_mat4(Vec3 translation, f32 radians, Vec3 axis, Vec3 scale) {
+    Mat4 out = rotate_mat4(radians, axis);
+    out.column[0] = _mm_mul_ps(out.column[0], _mm_set1_ps(scale.x));
+    out.column[1] = _mm_mul_ps(out.column[1], _mm_set1_ps(scale.y));
+    out.column[2] = _mm_mul_ps(out.column[2], _mm_set1_ps(scale.z));
+    out.column[3] =
+        _mm_setr_ps(translation.x, translation.y, translation.z, 1.0f);
+    return out;
+}
+
 static Mat4 perspective_mat4(f32 fov_radians,
                              f32 aspect_ratio,
                              f32 near,
@@ -0,0 +1,44 @@
+#version 330 core
+
+precision mediump float;
+
+layout(location = 0) in vec3 IN_POSITION;
+layout(location = 1) in vec3 IN_COLOR;
+// NOTE: Per-instance; one tightly packed array each (see `particle.h`).
+layout(location = 2) in float IN_X;
+layout(location = 3) in float IN_Y;
+layout(location = 4) in float IN_Z;
+layout(location = 5) in float IN_SIZE;
+
+out vec3  VERT_OUT_COLOR;
+out vec3  VERT_OUT_VIEW;
+out float gl_ClipDistance[2];
+
+// NOTE: Views work as in `vert.glsl`.
+#define CAP_VIEWS 4
+
+uniform mat4 U_VIEW;
+uniform mat4 U_VIEW_PROJECTIONS[CAP_VIEWS];
+uniform int  U_VIEW_FIRST;
+uniform int  U_VIEW_COUNT;
+uniform int  U_VIEW_TILES;
+
+#define COLOR vec3(1.0, 0.65, 0.3)
+
+// NOTE: Mirrors `get_tile` in `vert.glsl`.
+vec4 get_tile(vec4 position, int view) {
+    gl_ClipDistance[0] = position.w + position.x;
+    gl_ClipDistance[1] = position.w - position.x;
+    float n = float(U_VIEW_TILES);
+    position.x = (position.x + position.w * (float(2 * view + 1) - n)) / n;
+    return position;
+}
+
+void main() {
+    VERT_OUT_COLOR = mix(COLOR, IN_COLOR, 0.25);
+    vec4 world =
+        vec4((IN_POSITION * IN_SIZE) + vec3(IN_X, IN_Y, IN_Z), 1.0);
+    VERT_OUT_VIEW = (U_VIEW * world).xyz;
+    int view = U_VIEW_FIRST + (gl_InstanceID % U_VIEW_COUNT);
+    gl_Position = get_tile(U_VIEW_PROJECTIONS[view] * world, view);
+}
@@ -0,0 +1,269 @@
+#ifndef __PARTICLE_H__
+#define __PARTICLE_H__
+
+#include "math.h"
+#include "pool.h"
+
+#ifndef __AVX2__
+    #error "`particle.h` needs AVX2; see `-march=native` in `main`"
+#endif
+
+// NOTE: Must be a multiple of 8; particles are processed eight at a time.
+#define CAP_PARTICLES (1 << 20)
+
+// NOTE: Fewer live particles than this are updated on the calling thread.
+#define PARTICLE_PARALLEL_MIN 16384
+
+typedef __m256  Simd8f32;
+typedef __m256i Simd8u32;
+
+typedef struct {
+    _Alignas(32) f32 x[CAP_PARTICLES];
+    _Alignas(32) f32 y[CAP_PARTICLES];
+    _Alignas(32) f32 z[CAP_PARTICLES];
+    _Alignas(32) f32 vx[CAP_PARTICLES];
+    _Alignas(32) f32 vy[CAP_PARTICLES];
+    _Alignas(32) f32 vz[CAP_PARTICLES];
+    _Alignas(32) f32 life[CAP_PARTICLES]; // NOTE: Seconds left.
+} ParticleArrays;
+
+typedef struct {
+    Vec3 origin;
+    f32  radius;    // NOTE: Spawn jitter around `origin`.
+    f32  spread;    // NOTE: Initial speed range along `x` and `z`.
+    f32  speed_min; // NOTE: Initial speed range along `y`.
+    f32  speed_max;
+    f32  life_min;
+    f32  life_max;
+    f32  rate; // NOTE: Particles per second.
+    f32  gravity;
+    f32  size;
+} Emitter;
+
+// NOTE: State is double-buffered; each update reads `read`, compacts the
+// survivors into `write` and swaps the two. Survivors are also written to
+// `out` as four tightly packed arrays (`x`, `y`, `z`, `size`), each
+// `CAP_PARTICLES` long, which is the layout of the instance buffer it is
+// usually mapped from.
+typedef struct {
+    Simd8u32        seeds[CAP_THREADS];
+    ParticleArrays* read;
+    ParticleArrays* write;
+    f32*            out;
+    Emitter         emitter;
+    f32             dt;
+    f32             carry;
+    u32             len;
+    u32             emit_first;
+    u32             emit_len;
+    u32             count;
+    u32             alive[CAP_THREADS];
+    u32             offsets[CAP_THREADS];
+} Particles;
+
+// NOTE: `PARTICLE_PACK[mask]` moves the lanes set in `mask` to the front,
+// in order.
+static u32 PARTICLE_PACK[1 << 8][8];
+
+static void init_particles(Particles*      particles,
+                           ParticleArrays* arrays,
+                           Emitter         emitter) {
+    for (u32 mask = 0; mask < (1 << 8); ++mask) {
+        u32 n = 0;
+        for (u32 i = 0; i < 8; ++i) {
+            if (mask & (1u << i)) {
+                PARTICLE_PACK[mask][n++] = i;
+            }
+        }
+        for (; n < 8; ++n) {
+            PARTICLE_PACK[mask][n] = 0;
+        }
+    }
+    u32 seed = 0x6A09E667;
+    for (u32 i = 0; i < CAP_THREADS; ++i) {
+        u32 lanes[8];
+        for (u32 j = 0; j < 8; ++j) {
+            random_f32(&seed);
+            lanes[j] = seed;
+        }
+        particles->seeds[i] = _mm256_loadu_si256((const void*)lanes);
+    }
+    particles->read = &arrays[0];
+    particles->write = &arrays[1];
+    particles->emitter = emitter;
+    particles->carry = 0.0f;
+    particles->len = 0;
+}
+
+// NOTE: Eight lanes of `random_f32`, one xorshift32 state per lane.
+static Simd8f32 random_simd8f32(Simd8u32* state, f32 low, f32 high) {
+    Simd8u32 x = *state;
+    x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 13));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 17));
+    x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 5));
+    *state = x;
+    Simd8f32 t = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(x, 8)),
+                               _mm256_set1_ps(1.0f / (f32)(1 << 24)));
+    return _mm256_add_ps(_mm256_set1_ps(low),
+                         _mm256_mul_ps(t, _mm256_set1_ps(high - low)));
+}
+
+// NOTE: Like `get_chunk`, but in whole groups of eight particles.
+static Chunk get_particle_chunk(u32 len, u32 index, u32 count) {
+    Chunk chunk = get_chunk((len + 7) / 8, index, count);
+    chunk.begin *= 8;
+    chunk.end *= 8;
+    return chunk;
+}
+
+static void set_emit(void* payload, u32 index, u32 count) {
+    Particles*      particles = payload;
+    ParticleArrays* arrays = particles->read;
+    const Emitter*  emitter = &particles->emitter;
+    Chunk           chunk = get_chunk(particles->emit_len / 8, index, count);
+    Simd8u32        seed = particles->seeds[index];
+    Vec3            origin = emitter->origin;
+    f32             radius = emitter->radius;
+    u32             first = particles->emit_first;
+    for (u32 i = first + (chunk.begin * 8); i < first + (chunk.end * 8);
+         i += 8)
+    {
+        _mm256_storeu_ps(
+            &arrays->x[i],
+            random_simd8f32(&seed, origin.x - radius, origin.x + radius));
+        _mm256_storeu_ps(
+            &arrays->y[i],
+            random_simd8f32(&seed, origin.y - radius, origin.y + radius));
+        _mm256_storeu_ps(
+            &arrays->z[i],
+            random_simd8f32(&seed, origin.z - radius, origin.z + radius));
+        _mm256_storeu_ps(
+            &arrays->vx[i],
+            random_simd8f32(&seed, -emitter->spread, emitter->spread));
+        _mm256_storeu_ps(
+            &arrays->vy[i],
+            random_simd8f32(&seed, emitter->speed_min, emitter->speed_max));
+        _mm256_storeu_ps(
+            &arrays->vz[i],
+            random_simd8f32(&seed, -emitter->spread, emitter->spread));
+        _mm256_storeu_ps(
+            &arrays->life[i],
+            random_simd8f32(&seed, emitter->life_min, emitter->life_max));
+    }
+    particles->seeds[index] = seed;
+}
+
+static void set_kill(void* payload, u32 index, u32 count) {
+    Particles*      particles = payload;
+    ParticleArrays* arrays = particles->read;
+    Chunk           chunk = get_particle_chunk(particles->len, index, count);
+    Simd8f32        dt = _mm256_set1_ps(particles->dt);
+    Simd8f32        zero = _mm256_setzero_ps();
+    u32             alive = 0;
+    for (u32 i = chunk.begin; i < chunk.end; i += 8) {
+        Simd8f32 life = _mm256_sub_ps(_mm256_load_ps(&arrays->life[i]), dt);
+        _mm256_store_ps(&arrays->life[i], life);
+        alive += (u32)__builtin_popcount(
+            (u32)_mm256_movemask_ps(_mm256_cmp_ps(life, zero, _CMP_GT_OQ)));
+    }
+    particles->alive[index] = alive;
+}
+
+// NOTE: Writes the first `popcount(mask)` packed lanes to `out`; nothing
+// past them is touched, so neighbouring threads never race.
+static void set_pack(f32* out, Simd8f32 x, Simd8u32 pack, Simd8u32 store) {
+    _mm256_maskstore_ps(out, store, _mm256_permutevar8x32_ps(x, pack));
+}
+
+static void set_integrate(void* payload, u32 index, u32 count) {
+    Particles*            particles = payload;
+    const ParticleArrays* read = particles->read;
+    ParticleArrays*       write = particles->write;
+    f32*                  out = particles->out;
+    Chunk    chunk = get_particle_chunk(particles->len, index, count);
+    Simd8f32 dt = _mm256_set1_ps(particles->dt);
+    Simd8f32 gravity =
+        _mm256_set1_ps(particles->emitter.gravity * particles->dt);
+    Simd8f32 size = _mm256_set1_ps(particles->emitter.size);
+    Simd8f32 zero = _mm256_setzero_ps();
+    Simd8f32 one = _mm256_set1_ps(1.0f);
+    Simd8u32 lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    u32      cursor = particles->offsets[index];
+    for (u32 i = chunk.begin; i < chunk.end; i += 8) {
+        Simd8f32 life = _mm256_load_ps(&read->life[i]);
+        u32      mask =
+            (u32)_mm256_movemask_ps(_mm256_cmp_ps(life, zero, _CMP_GT_OQ));
+        Simd8u32 pack =
+            _mm256_loadu_si256((const void*)PARTICLE_PACK[mask]);
+        Simd8u32 store =
+            _mm256_cmpgt_epi32(_mm256_set1_epi32(__builtin_popcount(mask)),
+                               lanes);
+        Simd8f32 vx = _mm256_load_ps(&read->vx[i]);
+        Simd8f32 vy = _mm256_add_ps(_mm256_load_ps(&read->vy[i]), gravity);
+        Simd8f32 vz = _mm256_load_ps(&read->vz[i]);
+        Simd8f32 x =
+            _mm256_add_ps(_mm256_load_ps(&read->x[i]), _mm256_mul_ps(vx, dt));
+        Simd8f32 y =
+            _mm256_add_ps(_mm256_load_ps(&read->y[i]), _mm256_mul_ps(vy, dt));
+        Simd8f32 z =
+            _mm256_add_ps(_mm256_load_ps(&read->z[i]), _mm256_mul_ps(vz, dt));
+        // NOTE: Shrink away over the last second of life.
+        Simd8f32 scale = _mm256_mul_ps(_mm256_min_ps(life, one), size);
+        set_pack(&write->x[cursor], x, pack, store);
+        set_pack(&write->y[cursor], y, pack, store);
+        set_pack(&write->z[cursor], z, pack, store);
+        set_pack(&write->vx[cursor], vx, pack, store);
+        set_pack(&write->vy[cursor], vy, pack, store);
+        set_pack(&write->vz[cursor], vz, pack, store);
+        set_pack(&write->life[cursor], life, pack, store);
+        set_pack(&out[cursor], x, pack, store);
+        set_pack(&out[CAP_PARTICLES + cursor], y, pack, store);
+        set_pack(&out[(CAP_PARTICLES * 2) + cursor], z, pack, store);
+        set_pack(&out[(CAP_PARTICLES * 3) + cursor], scale, pack, store);
+        cursor += (u32)__builtin_popcount(mask);
+    }
+}
+
+static void run_particles(Particles* particles, Pool* pool, Job job) {
+    if (particles->count == 1) {
+        job(particles, 0, 1);
+    } else {
+        run_pool(pool, job, particles);
+    }
+}
+
+// NOTE: Emit, then age and count survivors, then integrate and compact them.
+// Splitting the count from the compaction lets every thread write its
+// survivors straight to their final offset.
+static void update_particles(Particles* particles, Pool* pool, f32 dt) {
+    particles->dt = dt;
+    particles->carry += particles->emitter.rate * dt;
+    u32 n = ((u32)particles->carry) & ~7u;
+    particles->carry -= (f32)n;
+    u32 room = (CAP_PARTICLES - particles->len) & ~7u;
+    particles->emit_first = particles->len;
+    particles->emit_len = n < room ? n : room;
+    particles->len += particles->emit_len;
+    particles->count =
+        PARTICLE_PARALLEL_MIN <= particles->len ? pool->len_threads : 1;
+    if (particles->emit_len != 0) {
+        run_particles(particles, pool, set_emit);
+    }
+    // NOTE: Lanes past `len` in the last group must read as dead.
+    for (u32 i = particles->len; (i & 7) != 0; ++i) {
+        particles->read->life[i] = 0.0f;
+    }
+    run_particles(particles, pool, set_kill);
+    u32 offset = 0;
+    for (u32 i = 0; i < particles->count; ++i) {
+        particles->offsets[i] = offset;
+        offset += particles->alive[i];
+    }
+    run_particles(particles, pool, set_integrate);
+    ParticleArrays* arrays = particles->read;
+    particles->read = particles->write;
+    particles->write = arrays;
+    particles->len = offset;
+}
+
+#endif
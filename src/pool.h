@@ -0,0 +1,140 @@
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include "prelude.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// NOTE: Includes the calling thread, which always takes part in the work.
+#define CAP_THREADS 16
+
+// NOTE: `index` is in `[0, count)`; jobs split their own ranges with
+// `get_chunk`.
+typedef void (*Job)(void* payload, u32 index, u32 count);
+
+typedef struct Pool Pool;
+
+typedef struct {
+    Pool* pool;
+    u32   index;
+} Worker;
+
+struct Pool {
+    pthread_t       threads[CAP_THREADS];
+    Worker          workers[CAP_THREADS];
+    pthread_mutex_t mutex;
+    pthread_cond_t  start;
+    pthread_cond_t  done;
+    Job             job;
+    void*           payload;
+    u32             len_threads;
+    u32             generation;
+    u32             pending;
+    Bool            stop;
+};
+
+typedef struct {
+    u32 begin;
+    u32 end;
+} Chunk;
+
+static Chunk get_chunk(u32 len, u32 index, u32 count) {
+    Chunk chunk = {
+        .begin = (u32)(((u64)len * index) / count),
+        .end = (u32)(((u64)len * (index + 1)) / count),
+    };
+    return chunk;
+}
+
+static void* loop_worker(void* payload) {
+    Worker* worker = payload;
+    Pool*   pool = worker->pool;
+    u32     generation = 0;
+    for (;;) {
+        pthread_mutex_lock(&pool->mutex);
+        while ((pool->generation == generation) && !pool->stop) {
+            pthread_cond_wait(&pool->start, &pool->mutex);
+        }
+        if (pool->stop) {
+            pthread_mutex_unlock(&pool->mutex);
+            return NULL;
+        }
+        generation = pool->generation;
+        Job   job = pool->job;
+        void* job_payload = pool->payload;
+        pthread_mutex_unlock(&pool->mutex);
+        job(job_payload, worker->index, pool->len_threads);
+        pthread_mutex_lock(&pool->mutex);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+        pthread_mutex_unlock(&pool->mutex);
+    }
+}
+
+static void init_pool(Pool* pool) {
+    i64 online = sysconf(_SC_NPROCESSORS_ONLN);
+    if (online < 1) {
+        online = 1;
+    } else if (CAP_THREADS < online) {
+        online = CAP_THREADS;
+    }
+    pool->len_threads = (u32)online;
+    pool->generation = 0;
+    pool->pending = 0;
+    pool->stop = FALSE;
+    if (pthread_mutex_init(&pool->mutex, NULL) ||
+        pthread_cond_init(&pool->start, NULL) ||
+        pthread_cond_init(&pool->done, NULL))
+    {
+        ERROR("Unable to initialize pool");
+    }
+    for (u32 i = 1; i < pool->len_threads; ++i) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+        if (pthread_create(&pool->threads[i],
+                           NULL,
+                           loop_worker,
+                           &pool->workers[i]))
+        {
+            ERROR("`pthread_create` failed");
+        }
+    }
+}
+
+static void run_pool(Pool* pool, Job job, void* payload) {
+    if (pool->len_threads == 1) {
+        job(payload, 0, 1);
+        return;
+    }
+    pthread_mutex_lock(&pool->mutex);
+    pool->job = job;
+    pool->payload = payload;
+    pool->pending = pool->len_threads - 1;
+    ++pool->generation;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->mutex);
+    job(payload, 0, pool->len_threads);
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->pending != 0) {
+        pthread_cond_wait(&pool->done, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void free_pool(Pool* pool) {
+    pthread_mutex_lock(&pool->mutex);
+    pool->stop = TRUE;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->mutex);
+    for (u32 i = 1; i < pool->len_threads; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->mutex);
+}
+
+#endif
@@ -6,9 +6,11 @@
 
 typedef uint8_t  u8;
 typedef uint32_t u32;
+typedef uint64_t u64;
 typedef size_t   usize;
 
 typedef int32_t i32;
+typedef int64_t i64;
 
 typedef float  f32;
 typedef double f64;
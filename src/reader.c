@@ -0,0 +1,326 @@
+#include "telemetry.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// NOTE: Live view of what `bin/main` pushes through `telemetry.h`. Runs in
+// its own process so terminal I/O never lands on the render thread.
+//
+//     $ bin/reader        # NOTE: Live summary and frame-time histogram.
+//     $ bin/reader csv    # NOTE: Stream every record as CSV.
+//     $ bin/reader views  # NOTE: Single pass vs. one pass per view.
+
+#define WINDOW            240
+#define COUNT_BUCKETS     16
+#define BUCKET_WIDTH      2000.0f
+#define HISTOGRAM_WIDTH   48
+#define POLL_MICROSECONDS 10000
+#define LIVE_MICROSECONDS 250000
+
+// NOTE: Records straddling a switch of view count or mode are skipped;
+// the GPU counters are read back a few frames late.
+#define VIEW_SETTLE_FRAMES 8
+#define CAP_VIEW_ROWS      8
+
+typedef struct {
+    u64 frames;
+    f64 submit;
+    f64 gpu;
+    f64 draw_calls;
+    f64 primitives;
+} ViewStats;
+
+static TelemetryRecord RECORDS[WINDOW];
+static f32             SORTED[WINDOW];
+static ViewStats       VIEW_STATS[CAP_VIEW_ROWS][2];
+
+static const Telemetry* get_telemetry_map(void) {
+    i32 file = shm_open(TELEMETRY_NAME, O_RDONLY, 0);
+    if (file < 0) {
+        ERROR("`shm_open` failed (is `bin/main` running?)");
+    }
+    const Telemetry* telemetry =
+        mmap(NULL, sizeof(Telemetry), PROT_READ, MAP_SHARED, file, 0);
+    close(file);
+    if (telemetry == MAP_FAILED) {
+        ERROR("`mmap` failed");
+    }
+    if ((telemetry->magic != TELEMETRY_MAGIC) ||
+        (telemetry->version != TELEMETRY_VERSION) ||
+        (telemetry->capacity != CAP_TELEMETRY) ||
+        (telemetry->size_record != sizeof(TelemetryRecord)))
+    {
+        ERROR("Telemetry layout mismatch");
+    }
+    return telemetry;
+}
+
+static u64 get_len(const Telemetry* telemetry) {
+    return atomic_load_explicit(&telemetry->len, memory_order_acquire);
+}
+
+static void print_csv_header(void) {
+    printf("frame,time,frame_time_us");
+    for (u32 i = 0; i < COUNT_PASSES; ++i) {
+        printf(",%s_us", PASS_NAMES[i]);
+    }
+    printf(",eye_x,eye_y,eye_z,target_x,target_y,target_z,instances,"
+           "particles,world_chunks,world_queued,lights,light_indices,"
+           "light_overflow,samples,pixels,sorted,views,single_pass,"
+           "draw_calls,primitives,world_bytes,gpu_bytes,max_rss_bytes\n");
+}
+
+static void print_csv_record(const TelemetryRecord* record) {
+    printf("%lu,%.6f,%.1f", record->frame, record->time, record->frame_time);
+    for (u32 i = 0; i < COUNT_PASSES; ++i) {
+        printf(",%.1f", record->passes[i]);
+    }
+    printf(",%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,"
+           "%u,%u,%u,%u,%lu,%lu,%lu\n",
+           record->eye[0],
+           record->eye[1],
+           record->eye[2],
+           record->target[0],
+           record->target[1],
+           record->target[2],
+           record->instances,
+           record->particles,
+           record->world_chunks,
+           record->world_queued,
+           record->lights,
+           record->light_indices,
+           record->light_overflow,
+           record->samples,
+           record->pixels,
+           record->sorted,
+           record->views,
+           record->single_pass,
+           record->draw_calls,
+           record->primitives,
+           record->world_bytes,
+           record->gpu_bytes,
+           record->max_rss_bytes);
+}
+
+static void loop_csv(const Telemetry* telemetry) {
+    print_csv_header();
+    u64 cursor = 0;
+    for (;;) {
+        u64 len = get_len(telemetry);
+        if ((CAP_TELEMETRY < len) && (cursor < (len - CAP_TELEMETRY))) {
+            cursor = len - CAP_TELEMETRY;
+        }
+        for (; cursor < len; ++cursor) {
+            TelemetryRecord record;
+            if (get_telemetry(telemetry, cursor, &record)) {
+                print_csv_record(&record);
+            }
+        }
+        fflush(stdout);
+        usleep(POLL_MICROSECONDS);
+    }
+}
+
+static i32 compare_f32(const void* l, const void* r) {
+    f32 a = *(const f32*)l;
+    f32 b = *(const f32*)r;
+    return (a > b) - (a < b);
+}
+
+static void print_live(const TelemetryRecord* records, u32 n) {
+    TelemetryRecord sum = {0};
+    u32             buckets[COUNT_BUCKETS] = {0};
+    for (u32 i = 0; i < n; ++i) {
+        const TelemetryRecord* record = &records[i];
+        sum.frame_time += record->frame_time;
+        for (u32 j = 0; j < COUNT_PASSES; ++j) {
+            sum.passes[j] += record->passes[j];
+        }
+        u32 bucket = (u32)(record->frame_time / BUCKET_WIDTH);
+        ++buckets[COUNT_BUCKETS <= bucket ? COUNT_BUCKETS - 1 : bucket];
+        SORTED[i] = record->frame_time;
+    }
+    qsort(SORTED, n, sizeof(SORTED[0]), compare_f32);
+    const TelemetryRecord* last = &records[n - 1];
+    f32                    mean = sum.frame_time / (f32)n;
+    printf("\033[H\033[J"
+           "frame   :%12lu\n"
+           "fps     :%12.2f\n"
+           "mean    :%12.1f us\n"
+           "p50     :%12.1f us\n"
+           "p99     :%12.1f us\n"
+           "eye     :%8.2f%8.2f%8.2f\n"
+           "target  :%8.2f%8.2f%8.2f\n"
+           "inst.   :%12u%8s\n"
+           "parts.  :%12u\n"
+           "world   :%12u%12u%12.2f KiB\n"
+           "views   :%12u%12s\n"
+           "draws   :%12u%12u prims\n"
+           "lights  :%12u%12u%12u\n"
+           "fill    :%12.2f\n"
+           "gpu mem :%12.2f MiB\n"
+           "max rss :%12.2f MiB\n\n",
+           last->frame,
+           1000000.0f / mean,
+           mean,
+           SORTED[n / 2],
+           SORTED[(n * 99) / 100],
+           last->eye[0],
+           last->eye[1],
+           last->eye[2],
+           last->target[0],
+           last->target[1],
+           last->target[2],
+           last->instances,
+           last->sorted ? "sorted" : "",
+           last->particles,
+           last->world_chunks,
+           last->world_queued,
+           (f64)last->world_bytes / 1024.0,
+           last->views,
+           last->single_pass ? "1 pass" : "n passes",
+           last->draw_calls,
+           last->primitives,
+           last->lights,
+           last->light_indices,
+           last->light_overflow,
+           (f32)last->samples / (f32)last->pixels,
+           (f64)last->gpu_bytes / (1024.0 * 1024.0),
+           (f64)last->max_rss_bytes / (1024.0 * 1024.0));
+    for (u32 i = 0; i < COUNT_PASSES; ++i) {
+        printf("%-10s:%12.1f us\n", PASS_NAMES[i], sum.passes[i] / (f32)n);
+    }
+    printf("\n");
+    u32 max = 1;
+    for (u32 i = 0; i < COUNT_BUCKETS; ++i) {
+        if (max < buckets[i]) {
+            max = buckets[i];
+        }
+    }
+    for (u32 i = 0; i < COUNT_BUCKETS; ++i) {
+        u32 width = (buckets[i] * HISTOGRAM_WIDTH) / max;
+        printf("%s%3u ms |",
+               i == (COUNT_BUCKETS - 1) ? ">=" : "  ",
+               (u32)((f32)i * BUCKET_WIDTH / 1000.0f));
+        for (u32 j = 0; j < width; ++j) {
+            putchar('#');
+        }
+        printf(" %u\n", buckets[i]);
+    }
+    fflush(stdout);
+}
+
+static void loop_live(const Telemetry* telemetry) {
+    for (;;) {
+        u64 len = get_len(telemetry);
+        u64 first = len < WINDOW ? 0 : len - WINDOW;
+        u32 n = 0;
+        for (u64 i = first; i < len; ++i) {
+            if (get_telemetry(telemetry, i, &RECORDS[n])) {
+                ++n;
+            }
+        }
+        if (n != 0) {
+            print_live(RECORDS, n);
+        }
+        usleep(LIVE_MICROSECONDS);
+    }
+}
+
+static void push_view_stats(const TelemetryRecord* record) {
+    if ((record->views == 0) || (CAP_VIEW_ROWS < record->views)) {
+        return;
+    }
+    ViewStats* stats = &VIEW_STATS[record->views - 1][record->single_pass];
+    ++stats->frames;
+    stats->submit += (f64)record->passes[PASS_SUBMIT];
+    stats->gpu += (f64)record->passes[PASS_GPU];
+    stats->draw_calls += (f64)record->draw_calls;
+    stats->primitives += (f64)record->primitives;
+}
+
+// NOTE: Means per frame; `ratio` is how many times more the `n passes` row
+// costs than the matching `1 pass` row.
+static void print_view_stats(void) {
+    printf("\033[H\033[J"
+           "%-8s%-10s%10s%12s%12s%10s%12s%8s\n",
+           "views",
+           "mode",
+           "frames",
+           "submit us",
+           "gpu us",
+           "draws",
+           "prims",
+           "ratio");
+    for (u32 i = 0; i < CAP_VIEW_ROWS; ++i) {
+        for (u32 j = 0; j < 2; ++j) {
+            const ViewStats* stats = &VIEW_STATS[i][j];
+            if (stats->frames == 0) {
+                continue;
+            }
+            f64 n = (f64)stats->frames;
+            printf("%-8u%-10s%10lu%12.1f%12.1f%10.1f%12.0f",
+                   i + 1,
+                   j ? "1 pass" : "n passes",
+                   stats->frames,
+                   stats->submit / n,
+                   stats->gpu / n,
+                   stats->draw_calls / n,
+                   stats->primitives / n);
+            const ViewStats* single = &VIEW_STATS[i][1];
+            if (!j && (single->frames != 0) && (0.0 < single->submit)) {
+                printf("%8.2f",
+                       (stats->submit / n) /
+                           (single->submit / (f64)single->frames));
+            }
+            printf("\n");
+        }
+    }
+    fflush(stdout);
+}
+
+static void loop_views(const Telemetry* telemetry) {
+    u64 cursor = get_len(telemetry);
+    u32 views = 0;
+    u32 single_pass = 0;
+    u32 settle = 0;
+    for (;;) {
+        u64 len = get_len(telemetry);
+        if ((CAP_TELEMETRY < len) && (cursor < (len - CAP_TELEMETRY))) {
+            cursor = len - CAP_TELEMETRY;
+        }
+        for (; cursor < len; ++cursor) {
+            TelemetryRecord record;
+            if (!get_telemetry(telemetry, cursor, &record)) {
+                continue;
+            }
+            if ((record.views != views) || (record.single_pass != single_pass))
+            {
+                views = record.views;
+                single_pass = record.single_pass;
+                settle = VIEW_SETTLE_FRAMES;
+            }
+            if (settle != 0) {
+                --settle;
+                continue;
+            }
+            push_view_stats(&record);
+        }
+        print_view_stats();
+        usleep(LIVE_MICROSECONDS);
+    }
+}
+
+i32 main(i32 n, const char** args) {
+    const Telemetry* telemetry = get_telemetry_map();
+    if ((1 < n) && !strcmp(args[1], "csv")) {
+        loop_csv(telemetry);
+    } else if ((1 < n) && !strcmp(args[1], "views")) {
+        loop_views(telemetry);
+    } else if (n == 1) {
+        loop_live(telemetry);
+    } else {
+        ERROR("Usage: reader [csv|views]");
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,154 @@
+#ifndef __SCENE_H__
+#define __SCENE_H__
+
+#include "math.h"
+
+#include <string.h>
+
+#define CAP_NODES     256
+#define CAP_INSTANCES 256
+
+#define NODE_NONE     0xFFFFFFFF
+#define INSTANCE_NONE 0xFFFFFFFF
+
+// NOTE: Per-instance motion parameters; uploaded once and evaluated in
+// `vert.glsl` against `U_TIME`.
+typedef struct {
+    Vec3 axis;
+    f32  angular_velocity;
+    f32  phase;
+    f32  amplitude;
+} Animation;
+
+typedef enum {
+    DIRTY_LOCAL = 1 << 0,
+    DIRTY_WORLD = 1 << 1,
+} Dirty;
+
+// NOTE: Nodes are stored as a structure-of-arrays, sorted so that every
+// parent precedes its children (`parent[i] < i`). A single forward sweep is
+// then enough to propagate transforms, and it can start at the first dirty
+// node instead of the root.
+typedef struct {
+    Mat4 world[CAP_NODES];
+    Mat4 local[CAP_NODES];
+    Vec3 translation[CAP_NODES];
+    Vec3 axis[CAP_NODES];
+    Vec3 scale[CAP_NODES];
+    f32  radians[CAP_NODES];
+    u32  parent[CAP_NODES];
+    u32  instance[CAP_NODES];
+    u8   dirty[CAP_NODES];
+    u32  len_nodes;
+    u32  first_dirty;
+    // NOTE: World matrices of drawable nodes, packed for upload. After
+    // `update_scene`, `[instance_first, instance_last)` covers every slot that
+    // changed.
+    Mat4 instances[CAP_INSTANCES];
+    u32  len_instances;
+    u32  instance_first;
+    u32  instance_last;
+} Scene;
+
+static void set_dirty(Scene* scene, u32 node) {
+    scene->dirty[node] |= DIRTY_LOCAL;
+    if (node < scene->first_dirty) {
+        scene->first_dirty = node;
+    }
+}
+
+static u32 push_node(Scene* scene,
+                     u32    parent,
+                     Vec3   translation,
+                     f32    radians,
+                     Vec3   axis,
+                     Vec3   scale) {
+    if (CAP_NODES <= scene->len_nodes) {
+        ERROR("CAP_NODES <= scene->len_nodes");
+    }
+    u32 node = scene->len_nodes++;
+    if ((parent != NODE_NONE) && (node <= parent)) {
+        ERROR("node <= parent");
+    }
+    scene->translation[node] = translation;
+    scene->radians[node] = radians;
+    scene->axis[node] = axis;
+    scene->scale[node] = scale;
+    scene->parent[node] = parent;
+    scene->instance[node] = INSTANCE_NONE;
+    scene->dirty[node] = 0;
+    set_dirty(scene, node);
+    return node;
+}
+
+static void push_instance(Scene* scene, u32 node) {
+    if (CAP_INSTANCES <= scene->len_instances) {
+        ERROR("CAP_INSTANCES <= scene->len_instances");
+    }
+    scene->instance[node] = scene->len_instances++;
+    set_dirty(scene, node);
+}
+
+static void set_translation(Scene* scene, u32 node, Vec3 translation) {
+    scene->translation[node] = translation;
+    set_dirty(scene, node);
+}
+
+static void set_rotation(Scene* scene, u32 node, f32 radians, Vec3 axis) {
+    scene->radians[node] = radians;
+    scene->axis[node] = axis;
+    set_dirty(scene, node);
+}
+
+static void set_scale(Scene* scene, u32 node, Vec3 scale) {
+    scene->scale[node] = scale;
+    set_dirty(scene, node);
+}
+
+static void update_scene(Scene* scene) {
+    scene->instance_first = scene->len_instances;
+    scene->instance_last = 0;
+    u32 first = scene->first_dirty;
+    if (scene->len_nodes <= first) {
+        return;
+    }
+    for (u32 i = first; i < scene->len_nodes; ++i) {
+        u8  dirty = scene->dirty[i];
+        u32 parent = scene->parent[i];
+        if ((parent != NODE_NONE) && (scene->dirty[parent] & DIRTY_WORLD)) {
+            dirty |= DIRTY_WORLD;
+        }
+        if (!dirty) {
+            continue;
+        }
+        if (dirty & DIRTY_LOCAL) {
+            scene->local[i] = trs_mat4(scene->translation[i],
+                                       scene->radians[i],
+                                       scene->axis[i],
+                                       scene->scale[i]);
+            dirty |= DIRTY_WORLD;
+        }
+        if (parent == NODE_NONE) {
+            scene->world[i] = scene->local[i];
+        } else {
+            scene->world[i] = mul_mat4(scene->world[parent], scene->local[i]);
+        }
+        // NOTE: Keep `DIRTY_WORLD` set until the sweep is over so children
+        // further down pick it up.
+        scene->dirty[i] = dirty;
+        u32 instance = scene->instance[i];
+        if (instance != INSTANCE_NONE) {
+            scene->instances[instance] = scene->world[i];
+            if (instance < scene->instance_first) {
+                scene->instance_first = instance;
+            }
+            if (scene->instance_last <= instance) {
+                scene->instance_last = instance + 1;
+            }
+        }
+    }
+    memset(&scene->dirty[first], 0, scene->len_nodes - first);
+    scene->first_dirty = scene->len_nodes;
+}
+
+#endif
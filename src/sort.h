@@ -0,0 +1,99 @@
+#ifndef __SORT_H__
+#define __SORT_H__
+
+#include "pool.h"
+
+#include <string.h>
+
+#define RADIX_BITS 8
+#define RADIX      (1 << RADIX_BITS)
+#define RADIX_MASK (RADIX - 1)
+
+// NOTE: Sixteen times `CAP_INSTANCES`, so the instance sort in `bin/main`
+// (64 keys, at most 256) always runs on the calling thread; only larger
+// callers fan out to the pool.
+#define SORT_PARALLEL_MIN 4096
+
+// NOTE: LSD radix sort of `(key, value)` pairs. `keys`/`values` and
+// `keys_swap`/`values_swap` are ping-ponged between passes; after
+// `sort_radix` returns, the sorted output is in `keys`/`values` (the pointers
+// may have been swapped).
+typedef struct {
+    u32* keys;
+    u32* values;
+    u32* keys_swap;
+    u32* values_swap;
+    u32  len;
+    u32  shift;
+    u32  histograms[CAP_THREADS][RADIX];
+} Sort;
+
+static void set_histogram(void* payload, u32 index, u32 count) {
+    Sort* sort = payload;
+    Chunk chunk = get_chunk(sort->len, index, count);
+    u32*  histogram = sort->histograms[index];
+    memset(histogram, 0, sizeof(sort->histograms[index]));
+    for (u32 i = chunk.begin; i < chunk.end; ++i) {
+        ++histogram[(sort->keys[i] >> sort->shift) & RADIX_MASK];
+    }
+}
+
+static void set_scatter(void* payload, u32 index, u32 count) {
+    Sort* sort = payload;
+    Chunk chunk = get_chunk(sort->len, index, count);
+    u32*  offsets = sort->histograms[index];
+    for (u32 i = chunk.begin; i < chunk.end; ++i) {
+        u32 key = sort->keys[i];
+        u32 j = offsets[(key >> sort->shift) & RADIX_MASK]++;
+        sort->keys_swap[j] = key;
+        sort->values_swap[j] = sort->values[i];
+    }
+}
+
+// NOTE: Turns per-thread digit counts into per-thread scatter offsets. Since
+// threads own contiguous input ranges in order, this keeps the sort stable.
+// Returns `FALSE` if every key shares the current digit, in which case the
+// pass can be skipped.
+static Bool set_offsets(Sort* sort, u32 count) {
+    u32 offset = 0;
+    for (u32 digit = 0; digit < RADIX; ++digit) {
+        u32 start = offset;
+        for (u32 i = 0; i < count; ++i) {
+            u32 n = sort->histograms[i][digit];
+            sort->histograms[i][digit] = offset;
+            offset += n;
+        }
+        if ((offset - start) == sort->len) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static void sort_radix(Sort* sort, Pool* pool) {
+    Bool parallel = SORT_PARALLEL_MIN <= sort->len;
+    u32  count = parallel ? pool->len_threads : 1;
+    for (sort->shift = 0; sort->shift < 32; sort->shift += RADIX_BITS) {
+        if (parallel) {
+            run_pool(pool, set_histogram, sort);
+        } else {
+            set_histogram(sort, 0, 1);
+        }
+        if (!set_offsets(sort, count)) {
+            continue;
+        }
+        if (parallel) {
+            run_pool(pool, set_scatter, sort);
+        } else {
+            set_scatter(sort, 0, 1);
+        }
+        u32* keys = sort->keys;
+        u32* values = sort->values;
+        sort->keys = sort->keys_swap;
+        sort->values = sort->values_swap;
+        sort->keys_swap = keys;
+        sort->values_swap = values;
+    }
+}
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef __TELEMETRY_H__
+#define __TELEMETRY_H__
+
+#include "prelude.h"
+
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// NOTE: Shared between `main.c` (the only writer) and `reader.c`; bump
+// `TELEMETRY_VERSION` whenever `TelemetryRecord` changes.
+#define TELEMETRY_NAME    "/glhf-telemetry"
+#define TELEMETRY_MAGIC   0x66686C67
+#define TELEMETRY_VERSION 5
+
+// NOTE: Must be a power of two.
+#define CAP_TELEMETRY 1024
+
+typedef enum {
+    PASS_INPUT = 0,
+    PASS_SCENE,
+    PASS_WORLD,
+    PASS_INSTANCES,
+    PASS_LIGHTS,
+    PASS_PARTICLES,
+    PASS_SUBMIT,
+    PASS_SWAP,
+    PASS_GPU,
+    COUNT_PASSES,
+} Pass;
+
+static const char* PASS_NAMES[COUNT_PASSES] = {
+    "input",
+    "scene",
+    "world",
+    "instances",
+    "lights",
+    "particles",
+    "submit",
+    "swap",
+    "gpu",
+};
+
+typedef struct {
+    u64 frame;
+    f64 time;       // NOTE: Seconds since start.
+    f32 frame_time; // NOTE: Microseconds since previous rendered frame.
+    f32 passes[COUNT_PASSES];
+    f32 eye[3];
+    f32 target[3];
+    u32 instances;
+    u32 particles;
+    u32 world_chunks; // NOTE: Resident on the GPU.
+    u32 world_queued; // NOTE: Paged in, waiting for upload budget.
+    u32 lights;
+    u32 light_indices;
+    u32 light_overflow;
+    u32 samples;
+    u32 pixels;
+    u32 sorted;
+    u32 views;
+    u32 single_pass;
+    u32 draw_calls;
+    u32 primitives; // NOTE: `GL_PRIMITIVES_GENERATED`, a few frames late.
+    u64 world_bytes; // NOTE: Uploaded this frame.
+    u64 gpu_bytes;
+    u64 max_rss_bytes;
+} TelemetryRecord;
+
+// NOTE: Per-slot seqlock. The writer bumps `sequence` to odd before
+// touching `record` and to `2 * (index + 1)` once done; a reader keeps a copy
+// only if it saw the same even value on both sides of the copy.
+typedef struct {
+    _Atomic u64     sequence;
+    TelemetryRecord record;
+} TelemetrySlot;
+
+typedef struct {
+    u32           magic;
+    u32           version;
+    u32           capacity;
+    u32           size_record;
+    _Atomic u64   len;
+    TelemetrySlot slots[CAP_TELEMETRY];
+} Telemetry;
+
+static void push_telemetry(Telemetry*             telemetry,
+                           const TelemetryRecord* record) {
+    u64 index = atomic_load_explicit(&telemetry->len, memory_order_relaxed);
+    TelemetrySlot* slot = &telemetry->slots[index & (CAP_TELEMETRY - 1)];
+    atomic_store_explicit(&slot->sequence,
+                          (2 * index) + 1,
+                          memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->record = *record;
+    atomic_store_explicit(&slot->sequence,
+                          2 * (index + 1),
+                          memory_order_release);
+    atomic_store_explicit(&telemetry->len, index + 1, memory_order_release);
+}
+
+static Bool get_telemetry(const Telemetry* telemetry,
+                          u64              index,
+                          TelemetryRecord* record) {
+    const TelemetrySlot* slot =
+        &telemetry->slots[index & (CAP_TELEMETRY - 1)];
+    u64 before = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (before != (2 * (index + 1))) {
+        return FALSE;
+    }
+    *record = slot->record;
+    atomic_thread_fence(memory_order_acquire);
+    u64 after = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+    return before == after;
+}
+
+#endif
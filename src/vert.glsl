@@ -5,19 +5,67 @@ precision mediump float;
 layout(location = 0) in vec3 IN_POSITION;
 layout(location = 1) in vec3 IN_COLOR;
 layout(location = 2) in mat4 IN_TRANSLATE;
+layout(location = 6) in vec4 IN_SPIN; // NOTE: (axis, angular_velocity)
+layout(location = 7) in vec2 IN_WAVE; // NOTE: (phase, amplitude)
 
-out vec3 VERT_OUT_COLOR;
+out vec3  VERT_OUT_COLOR;
+out vec3  VERT_OUT_VIEW;
+out float gl_ClipDistance[2];
+
+// NOTE: Mirrors `CAP_VIEWS` in `main.c`.
+#define CAP_VIEWS 4
 
 uniform mat4  U_MODEL;
 uniform float U_TIME;
-uniform mat4  U_PROJECTION;
-uniform mat4  U_VIEW;
-uniform mat4  U_TRANSFORM;
+uniform mat4  U_VIEW; // NOTE: Primary view; lighting happens in its space.
+uniform mat4  U_VIEW_PROJECTIONS[CAP_VIEWS];
+// NOTE: Each instance is drawn `U_VIEW_COUNT` times in a row (see
+// `glVertexAttribDivisor`), once per view starting at `U_VIEW_FIRST`.
+uniform int U_VIEW_FIRST;
+uniform int U_VIEW_COUNT;
+uniform int U_VIEW_TILES;
+
+// NOTE: Mirrors `rotate_mat4` in `math.h`; `axis` is normalized on upload.
+mat4 rotate(float radians, vec3 axis) {
+    float s = sin(radians);
+    float c = cos(radians);
+    vec3  t = axis * (1.0 - c);
+    return mat4(t.x * axis.x + c,
+                t.x * axis.y + axis.z * s,
+                t.x * axis.z - axis.y * s,
+                0.0,
+                t.x * axis.y - axis.z * s,
+                t.y * axis.y + c,
+                t.y * axis.z + axis.x * s,
+                0.0,
+                t.x * axis.z + axis.y * s,
+                t.y * axis.z - axis.x * s,
+                t.z * axis.z + c,
+                0.0,
+                0.0,
+                0.0,
+                0.0,
+                1.0);
+}
+
+// NOTE: Squeezes clip space into tile `view` of `U_VIEW_TILES`, laid out
+// left to right; the clip distances stand in for the tile's own side planes.
+vec4 get_tile(vec4 position, int view) {
+    gl_ClipDistance[0] = position.w + position.x;
+    gl_ClipDistance[1] = position.w - position.x;
+    float n = float(U_VIEW_TILES);
+    position.x = (position.x + position.w * (float(2 * view + 1) - n)) / n;
+    return position;
+}
 
 void main() {
     float t = cos(U_TIME / 5.0);
     VERT_OUT_COLOR = IN_COLOR * t * t;
+    mat4 transform = rotate((IN_SPIN.w * U_TIME) + IN_WAVE.x, IN_SPIN.xyz);
+    transform[3].y = IN_WAVE.y * sin(U_TIME + IN_WAVE.x);
     // NOTE: Multiplication order matters!
-    gl_Position = U_PROJECTION * U_VIEW * IN_TRANSLATE * U_TRANSFORM *
-        U_MODEL * vec4(IN_POSITION, 1.0);
+    vec4 world = IN_TRANSLATE * transform * U_MODEL * vec4(IN_POSITION, 1.0);
+    VERT_OUT_VIEW = (U_VIEW * world).xyz;
+    int view = U_VIEW_FIRST + (gl_InstanceID % U_VIEW_COUNT);
+    gl_Position = get_tile(U_VIEW_PROJECTIONS[view] * world, view);
 }
@@ -0,0 +1,144 @@
+#include "world.h"
+
+// NOTE: Writes a synthetic world in the format `world.h` streams from: a
+// square grid of chunks on the `x`/`z` plane, each a patch of rolling
+// terrain made of animated cubes.
+//
+//     $ bin/world path [chunks_per_side]
+//     $ bin/world --check path    # NOTE: Fails unless `bin/main` can load it.
+
+#define CHUNK_SIDE   16
+#define CHUNK_SIZE   16.0f
+#define WORLD_FLOOR  -14.0f
+#define WORLD_HILLS  2.5f
+#define DEFAULT_SIDE 64
+
+// NOTE: Covers the cube's half-diagonal under `MODEL` and `vert.glsl`'s bob.
+#define BOUNDS_PAD 1.5f
+
+static World     WORLD;
+static Mat4      TRANSFORMS[CAP_CHUNK_INSTANCES];
+static Animation ANIMATIONS[CAP_CHUNK_INSTANCES];
+
+static f32 get_height(f32 x, f32 z) {
+    return WORLD_FLOOR + (WORLD_HILLS * sinf(x * 0.11f) * cosf(z * 0.07f)) +
+           (0.5f * WORLD_HILLS * sinf((x + z) * 0.23f));
+}
+
+static void set_chunk(WorldChunk* chunk, f32 x, f32 z, u32* seed) {
+    const Vec3 up = {.x = 0.0f, .y = 1.0f, .z = 0.0f};
+    Vec3       min = {.x = x, .y = WORLD_FLOOR, .z = z};
+    Vec3       max = min;
+    u32        n = 0;
+    f32        step = CHUNK_SIZE / CHUNK_SIDE;
+    for (u32 i = 0; i < CHUNK_SIDE; ++i) {
+        for (u32 j = 0; j < CHUNK_SIDE; ++j) {
+            Vec3 position = {
+                .x = x + (((f32)i + random_f32(seed)) * step),
+                .z = z + (((f32)j + random_f32(seed)) * step),
+            };
+            position.y = get_height(position.x, position.z);
+            f32  size = 0.3f + (0.4f * random_f32(seed));
+            Vec3 scale = {.x = size, .y = size, .z = size};
+            TRANSFORMS[n] =
+                trs_mat4(position, random_f32(seed) * 2.0f * PI, up, scale);
+            Vec3 tilt = {
+                .x = random_f32(seed) - 0.5f,
+                .y = 1.0f,
+                .z = random_f32(seed) - 0.5f,
+            };
+            Animation animation = {
+                .axis = norm_vec3(tilt),
+                .angular_velocity =
+                    get_radians(10.0f + (50.0f * random_f32(seed))),
+                .phase = random_f32(seed) * 2.0f * PI,
+                .amplitude = 0.1f + (0.2f * random_f32(seed)),
+            };
+            ANIMATIONS[n++] = animation;
+            min.y = fminf(min.y, position.y);
+            max.y = fmaxf(max.y, position.y);
+        }
+    }
+    max.x = x + CHUNK_SIZE;
+    max.z = z + CHUNK_SIZE;
+    Vec3 pad = {.x = BOUNDS_PAD, .y = BOUNDS_PAD, .z = BOUNDS_PAD};
+    chunk->min = sub_vec3(min, pad);
+    chunk->max = add_vec3(max, pad);
+    chunk->len_instances = n;
+    chunk->_ = 0;
+}
+
+static void write_all(File* file, const void* data, usize size) {
+    if (fwrite(data, 1, size, file) != size) {
+        ERROR("`fwrite` failed");
+    }
+}
+
+i32 main(i32 n, const char** args) {
+    if ((n == 3) && !strcmp(args[1], "--check")) {
+        // NOTE: Runs the same validation as `bin/main`, which exits on any
+        // mismatch in version, layout or alignment.
+        open_world(&WORLD, args[2]);
+        printf("%u chunks, version %u\n",
+               WORLD.header->len_chunks,
+               WORLD.header->version);
+        return EXIT_SUCCESS;
+    }
+    if ((n < 2) || (3 < n)) {
+        ERROR("Usage: world [--check] path [chunks_per_side]");
+    }
+    u32 side = n == 3 ? (u32)atoi(args[2]) : DEFAULT_SIDE;
+    if ((side == 0) || (4096 < side)) {
+        ERROR("chunks_per_side out of range");
+    }
+    WorldHeader header = {
+        .magic = WORLD_MAGIC,
+        .version = WORLD_VERSION,
+        .len_chunks = side * side,
+        .cap_instances = CAP_CHUNK_INSTANCES,
+    };
+    WorldChunk* chunks = calloc(header.len_chunks, sizeof(WorldChunk));
+    if (!chunks) {
+        ERROR("`calloc` failed");
+    }
+    File* file = fopen(args[1], "wb");
+    if (!file) {
+        ERROR("Unable to open file");
+    }
+    // NOTE: Reserve the header and chunk table; they are rewritten once
+    // every offset is known.
+    write_all(file, &header, sizeof(header));
+    write_all(file, chunks, sizeof(WorldChunk) * header.len_chunks);
+    u64 offset = sizeof(header) + (sizeof(WorldChunk) * header.len_chunks);
+    const u8 padding[WORLD_ALIGN] = {0};
+    u32      seed = 0x5BD1E995;
+    f32      origin = -(CHUNK_SIZE * (f32)side) / 2.0f;
+    for (u32 i = 0; i < side; ++i) {
+        for (u32 j = 0; j < side; ++j) {
+            WorldChunk* chunk = &chunks[(i * side) + j];
+            set_chunk(chunk,
+                      origin + ((f32)i * CHUNK_SIZE),
+                      origin + ((f32)j * CHUNK_SIZE),
+                      &seed);
+            u64 aligned =
+                (offset + (WORLD_ALIGN - 1)) & ~(u64)(WORLD_ALIGN - 1);
+            write_all(file, padding, aligned - offset);
+            chunk->offset = aligned;
+            write_all(file, TRANSFORMS, sizeof(Mat4) * chunk->len_instances);
+            write_all(file,
+                      ANIMATIONS,
+                      sizeof(Animation) * chunk->len_instances);
+            offset = aligned + (SIZE_WORLD_INSTANCE * chunk->len_instances);
+        }
+    }
+    rewind(file);
+    write_all(file, &header, sizeof(header));
+    write_all(file, chunks, sizeof(WorldChunk) * header.len_chunks);
+    fclose(file);
+    free(chunks);
+    printf("%u chunks, %u instances, %lu bytes\n",
+           header.len_chunks,
+           header.len_chunks * CHUNK_SIDE * CHUNK_SIDE,
+           offset);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,379 @@
+#ifndef __WORLD_H__
+#define __WORLD_H__
+
+#include "math.h"
+#include "scene.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// NOTE: On-disk layout, native endian, written by `world.c`:
+//
+//     WorldHeader
+//     WorldChunk[len_chunks]
+//     per chunk, at `offset`: Mat4[len_instances], Animation[len_instances]
+//
+// Bump `WORLD_VERSION` whenever any of these change.
+#define WORLD_MAGIC   0x646C7277
+#define WORLD_VERSION 2
+
+// NOTE: Every chunk's `offset` is a multiple of this, so chunks never share
+// a (4 KiB) page and evicting one cannot drop a neighbour's pages.
+#define WORLD_ALIGN 4096
+
+#define CAP_CHUNK_INSTANCES 256
+
+// NOTE: Upper bound on chunks that are queued for upload or resident on the
+// GPU at once. Must be a power of two.
+#define CAP_WORLD_SLOTS 128
+
+// NOTE: Distances from `eye` to a chunk's bounds; the gap between the two
+// keeps chunks on the boundary from thrashing.
+#define WORLD_LOAD_RADIUS  56.0f
+#define WORLD_EVICT_RADIUS 72.0f
+
+// NOTE: How far `eye` has to move before the streamer looks again.
+#define WORLD_RESCAN_DISTANCE 2.0f
+
+#define WORLD_NONE 0xFFFFFFFF
+
+#define SIZE_WORLD_INSTANCE (sizeof(Mat4) + sizeof(Animation))
+#define SIZE_WORLD_SLOT     (SIZE_WORLD_INSTANCE * CAP_CHUNK_INSTANCES)
+
+typedef struct {
+    u32 magic;
+    u32 version;
+    u32 len_chunks;
+    u32 cap_instances;
+} WorldHeader;
+
+typedef struct {
+    Vec3 min;
+    Vec3 max;
+    u32  len_instances;
+    u32  _;
+    u64  offset;
+} WorldChunk;
+
+typedef enum {
+    CHUNK_UNLOADED = 0,
+    CHUNK_READY,
+    CHUNK_RESIDENT,
+    CHUNK_EVICTING,
+} ChunkState;
+
+// NOTE: The streaming thread decides what should be resident and pages it
+// in ahead of time; the render thread only copies already-faulted pages to
+// the GPU, as many as fit in its per-frame budget. Chunk ids move between
+// the two through the `ready` and `evict` rings, both guarded by `mutex`.
+typedef struct {
+    const u8*          map;
+    usize              size;
+    const WorldHeader* header;
+    const WorldChunk*  chunks;
+    u8*                states;
+    u64*               keys;
+    u32*               slots; // NOTE: Render thread only.
+    void               (*notify)(void);
+    pthread_t          thread;
+    pthread_mutex_t    mutex;
+    pthread_cond_t     wake;
+    Vec3               eye;
+    Vec3               scanned;
+    u32                ready[CAP_WORLD_SLOTS];
+    u32                ready_head;
+    u32                ready_len;
+    u32                evict[CAP_WORLD_SLOTS];
+    u32                evict_head;
+    u32                evict_len;
+    u32                committed;
+    u32                touched;
+    Bool               dirty;
+    Bool               stop;
+} World;
+
+static void open_world(World* world, const char* path) {
+    i32 file = open(path, O_RDONLY);
+    if (file < 0) {
+        ERROR("Unable to open world");
+    }
+    struct stat info;
+    if (fstat(file, &info)) {
+        ERROR("`fstat` failed");
+    }
+    world->size = (usize)info.st_size;
+    if (world->size < sizeof(WorldHeader)) {
+        ERROR("World too small");
+    }
+    void* map = mmap(NULL, world->size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (map == MAP_FAILED) {
+        ERROR("`mmap` failed");
+    }
+    // NOTE: Access follows the camera, not the file; readahead would only
+    // pull in chunks nobody asked for.
+    madvise(map, world->size, MADV_RANDOM);
+    world->map = map;
+    world->header = map;
+    world->chunks = (const void*)(world->map + sizeof(WorldHeader));
+    const WorldHeader* header = world->header;
+    if ((header->magic != WORLD_MAGIC) ||
+        (header->version != WORLD_VERSION) ||
+        (header->cap_instances != CAP_CHUNK_INSTANCES))
+    {
+        ERROR("World layout mismatch");
+    }
+    if (((world->size - sizeof(WorldHeader)) / sizeof(WorldChunk)) <
+        header->len_chunks)
+    {
+        ERROR("World chunk table truncated");
+    }
+    for (u32 i = 0; i < header->len_chunks; ++i) {
+        const WorldChunk* chunk = &world->chunks[i];
+        if ((CAP_CHUNK_INSTANCES < chunk->len_instances) ||
+            (world->size < chunk->offset) ||
+            ((world->size - chunk->offset) <
+             (SIZE_WORLD_INSTANCE * chunk->len_instances)))
+        {
+            ERROR("World chunk out of bounds");
+        }
+        if ((chunk->offset % WORLD_ALIGN) != 0) {
+            ERROR("World chunk misaligned");
+        }
+    }
+    world->states = calloc(header->len_chunks, sizeof(u8));
+    world->keys = calloc(header->len_chunks, sizeof(u64));
+    world->slots = calloc(header->len_chunks, sizeof(u32));
+    if (!world->states || !world->keys || !world->slots) {
+        ERROR("`calloc` failed");
+    }
+    for (u32 i = 0; i < header->len_chunks; ++i) {
+        world->slots[i] = WORLD_NONE;
+    }
+}
+
+static f32 get_chunk_distance(const WorldChunk* chunk, Vec3 eye) {
+    f32 x = fmaxf(fmaxf(chunk->min.x - eye.x, eye.x - chunk->max.x), 0.0f);
+    f32 y = fmaxf(fmaxf(chunk->min.y - eye.y, eye.y - chunk->max.y), 0.0f);
+    f32 z = fmaxf(fmaxf(chunk->min.z - eye.z, eye.z - chunk->max.z), 0.0f);
+    return (x * x) + (y * y) + (z * z);
+}
+
+// NOTE: Non-negative `f32` bits sort in the same order as their values, so
+// `(distance, chunk)` packs into one integer key.
+static u64 get_chunk_key(f32 distance, u32 chunk) {
+    u32 bits;
+    memcpy(&bits, &distance, sizeof(bits));
+    return ((u64)bits << 32) | chunk;
+}
+
+static i32 compare_u64(const void* l, const void* r) {
+    u64 a = *(const u64*)l;
+    u64 b = *(const u64*)r;
+    return (a > b) - (a < b);
+}
+
+static void get_chunk_pages(const World* world,
+                            u32          chunk,
+                            const u8**   first,
+                            usize*       len) {
+    usize page = (usize)sysconf(_SC_PAGESIZE);
+    usize begin = world->chunks[chunk].offset;
+    usize end =
+        begin + (SIZE_WORLD_INSTANCE * world->chunks[chunk].len_instances);
+    begin &= ~(page - 1);
+    *first = world->map + begin;
+    *len = end - begin;
+}
+
+// NOTE: Fault the chunk in here, so the render thread's copy never blocks on
+// the disk.
+static u32 touch_chunk(const World* world, u32 chunk) {
+    const u8* first;
+    usize     len;
+    get_chunk_pages(world, chunk, &first, &len);
+    madvise((void*)(usize)first, len, MADV_WILLNEED);
+    usize page = (usize)sysconf(_SC_PAGESIZE);
+    u32   sum = 0;
+    for (usize i = 0; i < len; i += page) {
+        sum += first[i];
+    }
+    return sum;
+}
+
+// NOTE: Only pages that lie wholly inside the chunk; with pages larger than
+// `WORLD_ALIGN` the edges may still hold a neighbour that is in use.
+static void drop_chunk(const World* world, u32 chunk) {
+    usize page = (usize)sysconf(_SC_PAGESIZE);
+    usize begin = world->chunks[chunk].offset;
+    usize end =
+        begin + (SIZE_WORLD_INSTANCE * world->chunks[chunk].len_instances);
+    begin = (begin + (page - 1)) & ~(page - 1);
+    end &= ~(page - 1);
+    if (begin < end) {
+        madvise((void*)(usize)(world->map + begin),
+                end - begin,
+                MADV_DONTNEED);
+    }
+}
+
+// NOTE: Called with `mutex` held; returns how many of the nearest unloaded
+// chunks in range fit, sorted into the front of `keys`.
+static u32 set_world_scan(World* world) {
+    Vec3 eye = world->eye;
+    f32  load = WORLD_LOAD_RADIUS * WORLD_LOAD_RADIUS;
+    f32  evict = WORLD_EVICT_RADIUS * WORLD_EVICT_RADIUS;
+    u32  n = 0;
+    world->scanned = eye;
+    world->dirty = FALSE;
+    for (u32 i = 0; i < world->header->len_chunks; ++i) {
+        f32 distance = get_chunk_distance(&world->chunks[i], eye);
+        switch ((ChunkState)world->states[i]) {
+        case CHUNK_UNLOADED: {
+            if (distance < load) {
+                world->keys[n++] = get_chunk_key(distance, i);
+            }
+            break;
+        }
+        case CHUNK_RESIDENT: {
+            if ((evict < distance) && (world->evict_len < CAP_WORLD_SLOTS)) {
+                world->evict[(world->evict_head + world->evict_len++) &
+                             (CAP_WORLD_SLOTS - 1)] = i;
+                world->states[i] = CHUNK_EVICTING;
+                drop_chunk(world, i);
+            }
+            break;
+        }
+        case CHUNK_READY:
+        case CHUNK_EVICTING: {
+            break;
+        }
+        }
+    }
+    qsort(world->keys, n, sizeof(world->keys[0]), compare_u64);
+    u32 room = CAP_WORLD_SLOTS - world->committed;
+    return n < room ? n : room;
+}
+
+static void* loop_world(void* payload) {
+    World* world = payload;
+    pthread_mutex_lock(&world->mutex);
+    for (;;) {
+        while (!world->dirty && !world->stop) {
+            pthread_cond_wait(&world->wake, &world->mutex);
+        }
+        if (world->stop) {
+            pthread_mutex_unlock(&world->mutex);
+            return NULL;
+        }
+        u32 n = set_world_scan(world);
+        // NOTE: Only this thread moves chunks out of `CHUNK_UNLOADED`, and
+        // `keys` is private to it, so paging in can happen unlocked.
+        pthread_mutex_unlock(&world->mutex);
+        for (u32 i = 0; i < n; ++i) {
+            world->touched += touch_chunk(world, (u32)world->keys[i]);
+        }
+        pthread_mutex_lock(&world->mutex);
+        for (u32 i = 0; i < n; ++i) {
+            u32 chunk = (u32)world->keys[i];
+            world->states[chunk] = CHUNK_READY;
+            world->ready[(world->ready_head + world->ready_len++) &
+                         (CAP_WORLD_SLOTS - 1)] = chunk;
+        }
+        world->committed += n;
+        if ((n != 0) && world->notify) {
+            world->notify();
+        }
+    }
+}
+
+// NOTE: `notify` (may be `NULL`) is called from the streaming thread whenever
+// new chunks are ready, so a render thread blocked on input can wake up.
+static void init_world(World* world, Vec3 eye, void (*notify)(void)) {
+    world->notify = notify;
+    world->eye = eye;
+    world->dirty = TRUE;
+    world->stop = FALSE;
+    if (pthread_mutex_init(&world->mutex, NULL) ||
+        pthread_cond_init(&world->wake, NULL))
+    {
+        ERROR("Unable to initialize world");
+    }
+    if (pthread_create(&world->thread, NULL, loop_world, world)) {
+        ERROR("`pthread_create` failed");
+    }
+}
+
+static void set_world_eye(World* world, Vec3 eye) {
+    pthread_mutex_lock(&world->mutex);
+    world->eye = eye;
+    Vec3 delta = sub_vec3(eye, world->scanned);
+    if ((WORLD_RESCAN_DISTANCE * WORLD_RESCAN_DISTANCE) <
+        dot_vec3(delta, delta))
+    {
+        world->dirty = TRUE;
+        pthread_cond_signal(&world->wake);
+    }
+    pthread_mutex_unlock(&world->mutex);
+}
+
+// NOTE: The chunk is `CHUNK_RESIDENT` once this returns; the caller must
+// upload it before the next draw.
+static Bool pop_world_ready(World* world, u32* chunk) {
+    pthread_mutex_lock(&world->mutex);
+    Bool popped = world->ready_len != 0;
+    if (popped) {
+        *chunk = world->ready[world->ready_head];
+        world->ready_head = (world->ready_head + 1) & (CAP_WORLD_SLOTS - 1);
+        --world->ready_len;
+        world->states[*chunk] = CHUNK_RESIDENT;
+    }
+    pthread_mutex_unlock(&world->mutex);
+    return popped;
+}
+
+// NOTE: The caller must release the chunk's GPU slot; this frees it up for
+// the streamer.
+static Bool pop_world_evict(World* world, u32* chunk) {
+    pthread_mutex_lock(&world->mutex);
+    Bool popped = world->evict_len != 0;
+    if (popped) {
+        *chunk = world->evict[world->evict_head];
+        world->evict_head = (world->evict_head + 1) & (CAP_WORLD_SLOTS - 1);
+        --world->evict_len;
+        world->states[*chunk] = CHUNK_UNLOADED;
+        --world->committed;
+        world->dirty = TRUE;
+        pthread_cond_signal(&world->wake);
+    }
+    pthread_mutex_unlock(&world->mutex);
+    return popped;
+}
+
+static u32 get_world_ready(World* world) {
+    pthread_mutex_lock(&world->mutex);
+    u32 len = world->ready_len;
+    pthread_mutex_unlock(&world->mutex);
+    return len;
+}
+
+static void free_world(World* world) {
+    pthread_mutex_lock(&world->mutex);
+    world->stop = TRUE;
+    pthread_cond_signal(&world->wake);
+    pthread_mutex_unlock(&world->mutex);
+    pthread_join(world->thread, NULL);
+    pthread_cond_destroy(&world->wake);
+    pthread_mutex_destroy(&world->mutex);
+    munmap((void*)(usize)world->map, world->size);
+    free(world->states);
+    free(world->keys);
+    free(world->slots);
+}
+
+#endif